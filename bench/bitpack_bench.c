@@ -0,0 +1,197 @@
+/*
+ * Size and speed of bitpack columns against writing every value at full
+ * width with obits_setdword, on records of timestamps (DELTA), small
+ * counters with outliers (FOR) and random words (the worst case). Every
+ * record is decoded and compared in both bit orders, sized again with a
+ * counting stream, and a few edge cases must round trip or fail with the
+ * right code.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "bitpack.h"
+
+#define NUM_RECORDS  2000
+#define RECORD       1000      /*values per record, 4000 bytes at full width*/
+#define ROUNDS       10
+
+static unsigned int columns[NUM_RECORDS][RECORD];
+static unsigned char wire[NUM_RECORDS][MAX_CODEC_BUFFER_LEN];
+static unsigned int decoded[RECORD];
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static void makecolumns(unsigned int kind)
+{
+    unsigned int i, j, t = 1700000000;
+
+    srand(7 + kind);
+    for(i = 0; i < NUM_RECORDS; i++)
+    {
+        for(j = 0; j < RECORD; j++)
+        {
+            if(kind == 0)
+                columns[i][j] = t += 1000 + rand() % 16 + (rand() % 200 == 0 ? 100000 : 0);
+            else if(kind == 1)
+                columns[i][j] = rand() % 100 == 0 ? (unsigned int)rand() : (unsigned int)(rand() % 300);
+            else
+                columns[i][j] = (unsigned int)rand() << 16 ^ (unsigned int)rand();
+        }
+    }
+}
+
+static unsigned short roundtrip(const unsigned int *values, unsigned int n, unsigned int mode, unsigned short order, unsigned int max)
+{
+    static unsigned char buf[MAX_CODEC_BUFFER_LEN];
+    static unsigned int got[BITPACK_MAXVALUES];
+    T_OutputBitStream out;
+    T_InputBitStream in;
+    unsigned int count;
+    unsigned short r;
+
+    obits_init(&out, buf, sizeof(buf));
+    obits_setorder(&out, order);
+    if((r = bitpack_encode(&out, values, n, mode)) != CODEC_OK)
+        return r;
+
+    ibits_init(&in, buf, (obits_getlen(&out) + 7) / 8);
+    ibits_setorder(&in, order);
+    if((r = bitpack_decode(&in, got, max, &count)) != CODEC_OK)
+        return r;
+
+    return count != n || memcmp(got, values, n * sizeof(*values)) ? BITPACK_CORRUPT : CODEC_OK;
+}
+
+static unsigned long edgecases(void)
+{
+    static unsigned int v[1000];
+    static unsigned char buf[64];
+    T_OutputBitStream out;
+    T_InputBitStream in;
+    unsigned int i, n, sizes[] = {0, 1, 4, 127, 128, 129, 255, 256, 1000};
+    unsigned short order;
+    unsigned long bad = 0;
+
+    for(order = CODEC_MSB_FIRST; order <= CODEC_LSB_FIRST; order++)
+    {
+        for(i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+        {
+            for(n = 0; n < sizes[i]; n++)
+                v[n] = n & 1 ? 0xFFFFFFFF : 0;          /*deltas wrap both ways*/
+            bad += roundtrip(v, sizes[i], BITPACK_DELTA, order, 1000) != CODEC_OK;
+            bad += roundtrip(v, sizes[i], BITPACK_FOR, order, 1000) != CODEC_OK;
+
+            for(n = 0; n < sizes[i]; n++)
+                v[n] = 42;
+            bad += roundtrip(v, sizes[i], BITPACK_DELTA, order, 1000) != CODEC_OK;
+            bad += roundtrip(v, sizes[i], BITPACK_FOR, order, 1000) != CODEC_OK;
+
+            for(n = 0; n < sizes[i]; n++)
+                v[n] = n % 37 == 5 ? 1u << (n % 32) : n % 3;
+            bad += roundtrip(v, sizes[i], BITPACK_FOR, order, 1000) != CODEC_OK;
+            bad += roundtrip(v, sizes[i], BITPACK_DELTA, order, 1000) != CODEC_OK;   /*more exceptions than the kernel sums past*/
+        }
+    }
+
+    bad += roundtrip(v, 300, BITPACK_FOR, CODEC_MSB_FIRST, 299) != BITPACK_TOOMANY;
+    bad += roundtrip(v, 300, 2, CODEC_MSB_FIRST, 300) != BITPACK_CORRUPT;
+
+    /*a column that does not fit, and one cut short*/
+    obits_init(&out, buf, sizeof(buf));
+    bad += bitpack_encode(&out, v, 300, BITPACK_FOR) != CODEC_SETTOOBITS;
+    obits_init(&out, wire[0], MAX_CODEC_BUFFER_LEN);
+    bitpack_encode(&out, columns[0], RECORD, BITPACK_FOR);
+    ibits_init(&in, wire[0], obits_getlen(&out) / 8 - 1);
+    bad += bitpack_decode(&in, decoded, RECORD, &n) != CODEC_GETTOOBITS;
+
+    return bad;
+}
+
+int main(void)
+{
+    static const char *names[] = {"timestamps", "counters", "random"};
+    static const unsigned int modes[] = {BITPACK_DELTA, BITPACK_FOR, BITPACK_FOR};
+    T_OutputBitStream out;
+    T_InputBitStream in;
+    unsigned int kind, i, n, r;
+    unsigned long bits, bad = 0;
+    unsigned short lens[NUM_RECORDS];
+    double tenc, tsize, tdec, tfull;
+
+    bad += edgecases();
+
+    for(kind = 0; kind < 3; kind++)
+    {
+        makecolumns(kind);
+
+        tfull = now();
+        for(r = 0; r < ROUNDS; r++)
+        {
+            for(i = 0; i < NUM_RECORDS; i++)
+            {
+                obits_init(&out, wire[i], MAX_CODEC_BUFFER_LEN);
+                for(n = 0; n < RECORD; n++)
+                    obits_setdword(&out, columns[i][n]);
+            }
+        }
+        tfull = now() - tfull;
+
+        tenc = now();
+        for(r = 0; r < ROUNDS; r++)
+        {
+            for(i = 0, bits = 0; i < NUM_RECORDS; i++)
+            {
+                obits_init(&out, wire[i], MAX_CODEC_BUFFER_LEN);
+                bad += bitpack_encode(&out, columns[i], RECORD, modes[kind]) != CODEC_OK;
+                lens[i] = (obits_getlen(&out) + 7) / 8;
+                bits += obits_getlen(&out);
+            }
+        }
+        tenc = now() - tenc;
+
+        /*a sizing pass over a counting stream must land on the same length*/
+        tsize = now();
+        for(r = 0; r < ROUNDS; r++)
+        {
+            for(i = 0; i < NUM_RECORDS; i++)
+            {
+                obits_init(&out, NULL, MAX_CODEC_BUFFER_LEN);
+                bitpack_encode(&out, columns[i], RECORD, modes[kind]);
+                bad += (obits_getlen(&out) + 7) / 8 != lens[i];
+            }
+        }
+        tsize = now() - tsize;
+
+        tdec = now();
+        for(r = 0; r < ROUNDS; r++)
+        {
+            for(i = 0; i < NUM_RECORDS; i++)
+            {
+                ibits_init(&in, wire[i], lens[i]);
+                bad += bitpack_decode(&in, decoded, RECORD, &n) != CODEC_OK || n != RECORD;
+                if(r == 0)
+                    bad += memcmp(decoded, columns[i], sizeof(decoded)) != 0;
+            }
+        }
+        tdec = now() - tdec;
+
+        for(i = 0; i < NUM_RECORDS; i++)
+            bad += roundtrip(columns[i], RECORD, modes[kind], CODEC_LSB_FIRST, RECORD) != CODEC_OK;
+
+        printf("%-10s %5.2f bits/value (%4.2fx smaller)  setdword %6.0f M/s  encode %6.0f M/s  size %6.0f M/s  decode %6.0f M/s\n",
+               names[kind], (double)bits / NUM_RECORDS / RECORD, 32.0 * NUM_RECORDS * RECORD / bits,
+               1e-6 * ROUNDS * NUM_RECORDS * RECORD / tfull,
+               1e-6 * ROUNDS * NUM_RECORDS * RECORD / tenc,
+               1e-6 * ROUNDS * NUM_RECORDS * RECORD / tsize,
+               1e-6 * ROUNDS * NUM_RECORDS * RECORD / tdec);
+    }
+
+    printf("%lu bad\n", bad);
+    return bad != 0;
+}
@@ -0,0 +1,393 @@
+/*
+ * Bins per second of the table-driven, byte-renormalizing CABAC coder in
+ * cabac.c against a bit-serial reference written straight from the H.264
+ * encoding/decoding flowcharts (9.3.3.2, 9.3.4.2) on obits_setbit/ibits_getbit
+ * of single bits. Each coder's output is also decoded by the other.
+ *
+ * Both coders do the same interval arithmetic per bin and differ only in
+ * renormalization, which costs a call per output bit: a skewed source
+ * spends well under a bit per bin, an equiprobable one with bypass bins
+ * about one. Both are run and the ratio printed. Encoding gains about 1.5x;
+ * decoding gains little, the reference reading only the bits it consumes.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "cabac.h"
+
+#define NUM_BINS      24000     /*skewed source*/
+#define NUM_FAIRBINS  30000     /*equiprobable source, about a bit each*/
+#define NUM_CONTEXTS  16
+#define ROUNDS        200
+
+/*reference tables are shared with the coder under test through decoding*/
+static const unsigned char refrangelps[64][4] = {
+    {128, 176, 208, 240}, {128, 167, 197, 227}, {128, 158, 187, 216}, {123, 150, 178, 205},
+    {116, 142, 169, 195}, {111, 135, 160, 185}, {105, 128, 152, 175}, {100, 122, 144, 166},
+    { 95, 116, 137, 158}, { 90, 110, 130, 150}, { 85, 104, 123, 142}, { 81,  99, 117, 135},
+    { 77,  94, 111, 128}, { 73,  89, 105, 122}, { 69,  85, 100, 116}, { 66,  80,  95, 110},
+    { 62,  76,  90, 104}, { 59,  72,  86,  99}, { 56,  69,  81,  94}, { 53,  65,  77,  89},
+    { 51,  62,  73,  85}, { 48,  59,  69,  80}, { 46,  56,  66,  76}, { 43,  53,  63,  72},
+    { 41,  50,  59,  69}, { 39,  48,  56,  65}, { 37,  45,  54,  62}, { 35,  43,  51,  59},
+    { 33,  41,  48,  56}, { 32,  39,  46,  53}, { 30,  37,  43,  50}, { 29,  35,  41,  48},
+    { 27,  33,  39,  45}, { 26,  31,  37,  43}, { 24,  30,  35,  41}, { 23,  28,  33,  39},
+    { 22,  27,  32,  37}, { 21,  26,  30,  35}, { 20,  24,  29,  33}, { 19,  23,  27,  31},
+    { 18,  22,  26,  30}, { 17,  21,  25,  28}, { 16,  20,  23,  27}, { 15,  19,  22,  25},
+    { 14,  18,  21,  24}, { 14,  17,  20,  23}, { 13,  16,  19,  22}, { 12,  15,  18,  21},
+    { 12,  14,  17,  20}, { 11,  14,  16,  19}, { 11,  13,  15,  18}, { 10,  12,  15,  17},
+    { 10,  12,  14,  16}, {  9,  11,  13,  15}, {  9,  11,  12,  14}, {  8,  10,  12,  14},
+    {  8,   9,  11,  13}, {  7,   9,  11,  12}, {  7,   9,  10,  12}, {  7,   8,  10,  11},
+    {  6,   8,   9,  11}, {  6,   7,   9,  10}, {  6,   7,   8,   9}, {  2,   2,   2,   2}
+    };
+
+static const unsigned char reftranslps[64] = {
+     0,  0,  1,  2,  2,  4,  4,  5,  6,  7,  8,  9,  9, 11, 11, 12,
+    13, 13, 15, 15, 16, 16, 18, 18, 19, 19, 21, 21, 22, 22, 23, 24,
+    24, 25, 26, 26, 27, 27, 28, 29, 29, 30, 30, 30, 31, 32, 32, 33,
+    33, 33, 34, 34, 35, 35, 35, 36, 36, 36, 37, 37, 37, 38, 38, 63
+    };
+
+typedef struct tagT_RefEncoder {
+    T_OutputBitStream *bits;
+    unsigned int low, range, outstanding;
+    int firstbit;
+} T_RefEncoder;
+
+typedef struct tagT_RefDecoder {
+    T_InputBitStream *bits;
+    unsigned int offset, range;
+} T_RefDecoder;
+
+/*a bin to code: ctx < 0 is bypass, NUM_CONTEXTS is the final terminate*/
+typedef struct tagT_Bin {
+    int ctx;
+    unsigned char bin;
+} T_Bin;
+
+static unsigned char refstate(T_CabacContext ctx, unsigned char bin)
+{
+    unsigned char state = ctx >> 1, mps = ctx & 1;
+
+    if(bin == mps)
+        return ((state < 62 ? state + 1 : state) << 1) | mps;
+
+    return (reftranslps[state] << 1) | (state == 0 ? !mps : mps);
+}
+
+static void ref_putbit(T_RefEncoder *enc, unsigned char b)
+{
+    if(enc->firstbit)
+        enc->firstbit = 0;
+    else
+        obits_setbit(enc->bits, 1, b);
+
+    for(; enc->outstanding > 0; enc->outstanding --)
+        obits_setbit(enc->bits, 1, !b);
+}
+
+static void ref_renorme(T_RefEncoder *enc)
+{
+    while(enc->range < 256)
+    {
+        if(enc->low < 256)
+        {
+            ref_putbit(enc, 0);
+        }
+        else if(enc->low >= 512)
+        {
+            enc->low -= 512;
+            ref_putbit(enc, 1);
+        }
+        else
+        {
+            enc->low -= 256;
+            enc->outstanding ++;
+        }
+        enc->range <<= 1;
+        enc->low <<= 1;
+    }
+}
+
+static void ref_encodebin(T_RefEncoder *enc, T_CabacContext *ctx, unsigned char bin)
+{
+    unsigned int lps = refrangelps[*ctx >> 1][(enc->range >> 6) & 3];
+
+    enc->range -= lps;
+    if(bin != (*ctx & 1))
+    {
+        enc->low += enc->range;
+        enc->range = lps;
+    }
+    *ctx = refstate(*ctx, bin);
+    ref_renorme(enc);
+}
+
+static void ref_encodebypass(T_RefEncoder *enc, unsigned char bin)
+{
+    enc->low <<= 1;
+    if(bin)
+        enc->low += enc->range;
+
+    if(enc->low >= 1024)
+    {
+        ref_putbit(enc, 1);
+        enc->low -= 1024;
+    }
+    else if(enc->low < 512)
+    {
+        ref_putbit(enc, 0);
+    }
+    else
+    {
+        enc->low -= 512;
+        enc->outstanding ++;
+    }
+}
+
+/*terminate with bin 1 and flush, including the rbsp stop bit*/
+static void ref_encodeend(T_RefEncoder *enc)
+{
+    enc->range -= 2;
+    enc->low += enc->range;
+    enc->range = 2;
+    ref_renorme(enc);
+    ref_putbit(enc, (enc->low >> 9) & 1);
+    obits_setbit(enc->bits, 2, ((enc->low >> 7) & 3) | 1);
+}
+
+static unsigned char ref_decodebin(T_RefDecoder *dec, T_CabacContext *ctx)
+{
+    unsigned int lps = refrangelps[*ctx >> 1][(dec->range >> 6) & 3];
+    unsigned char bin = *ctx & 1;
+
+    dec->range -= lps;
+    if(dec->offset >= dec->range)
+    {
+        bin = !bin;
+        dec->offset -= dec->range;
+        dec->range = lps;
+    }
+    *ctx = refstate(*ctx, bin);
+
+    while(dec->range < 256)
+    {
+        dec->range <<= 1;
+        dec->offset = (dec->offset << 1) | ibits_getbit(dec->bits, 1);
+    }
+    return bin;
+}
+
+static unsigned char ref_decodebypass(T_RefDecoder *dec)
+{
+    dec->offset = (dec->offset << 1) | ibits_getbit(dec->bits, 1);
+    if(dec->offset >= dec->range)
+    {
+        dec->offset -= dec->range;
+        return 1;
+    }
+    return 0;
+}
+
+static unsigned char ref_decodeterminate(T_RefDecoder *dec)
+{
+    dec->range -= 2;
+    if(dec->offset >= dec->range)
+        return 1;
+
+    while(dec->range < 256)
+    {
+        dec->range <<= 1;
+        dec->offset = (dec->offset << 1) | ibits_getbit(dec->bits, 1);
+    }
+    return 0;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*
+ * skewed: context i emits a one with probability (i + 1) / 64 and one bin
+ * in 8 is bypass, otherwise every bin is a fair coin and half are bypass
+ */
+static void makebins(T_Bin *bins, int n, int skewed)
+{
+    int i;
+
+    for(i=0; i<n-1; i++)
+    {
+        bins[i].ctx = (skewed ? rand() % 8 == 0 : rand() % 2 == 0) ? -1 : rand() % NUM_CONTEXTS;
+        bins[i].bin = bins[i].ctx < 0 || !skewed ? rand() & 1 : (rand() % 64) <= bins[i].ctx;
+    }
+    bins[n-1].ctx = NUM_CONTEXTS;
+    bins[n-1].bin = 1;
+}
+
+static unsigned short fastencode(const T_Bin *bins, int n, unsigned char *buf)
+{
+    T_OutputBitStream out;
+    T_CabacEncoder enc;
+    T_CabacContext ctx[NUM_CONTEXTS] = {0};
+    int i;
+
+    obits_init(&out, buf, MAX_CODEC_BUFFER_LEN);
+    cabac_encodeinit(&enc, &out);
+    for(i=0; i<n; i++)
+    {
+        if(bins[i].ctx < 0)
+            cabac_encodebypass(&enc, bins[i].bin);
+        else if(bins[i].ctx == NUM_CONTEXTS)
+            cabac_encodeterminate(&enc, bins[i].bin);
+        else
+            cabac_encodebin(&enc, &ctx[bins[i].ctx], bins[i].bin);
+    }
+    cabac_encodeflush(&enc);
+    return obits_geterror(&out) == CODEC_OK ? obits_getlen(&out) : 0;
+}
+
+static unsigned short refencode(const T_Bin *bins, int n, unsigned char *buf)
+{
+    T_OutputBitStream out;
+    T_RefEncoder enc;
+    T_CabacContext ctx[NUM_CONTEXTS] = {0};
+    int i;
+
+    obits_init(&out, buf, MAX_CODEC_BUFFER_LEN);
+    enc.bits = &out;
+    enc.low = 0;
+    enc.range = 510;
+    enc.outstanding = 0;
+    enc.firstbit = 1;
+    for(i=0; i<n-1; i++)
+    {
+        if(bins[i].ctx < 0)
+            ref_encodebypass(&enc, bins[i].bin);
+        else
+            ref_encodebin(&enc, &ctx[bins[i].ctx], bins[i].bin);
+    }
+    ref_encodeend(&enc);
+    return obits_geterror(&out) == CODEC_OK ? obits_getlen(&out) : 0;
+}
+
+static int fastdecode(const T_Bin *bins, int n, unsigned char *buf, unsigned short len)
+{
+    T_InputBitStream in;
+    T_CabacDecoder dec;
+    T_CabacContext ctx[NUM_CONTEXTS] = {0};
+    int i, bad = 0;
+    unsigned char bin;
+
+    ibits_init(&in, buf, len);
+    cabac_decodeinit(&dec, &in);
+    for(i=0; i<n; i++)
+    {
+        if(bins[i].ctx < 0)
+            bin = cabac_decodebypass(&dec);
+        else if(bins[i].ctx == NUM_CONTEXTS)
+            bin = cabac_decodeterminate(&dec);
+        else
+            bin = cabac_decodebin(&dec, &ctx[bins[i].ctx]);
+        bad |= bin != bins[i].bin;
+    }
+    return bad;
+}
+
+static int refdecode(const T_Bin *bins, int n, unsigned char *buf, unsigned short len)
+{
+    T_InputBitStream in;
+    T_RefDecoder dec;
+    T_CabacContext ctx[NUM_CONTEXTS] = {0};
+    int i, bad = 0;
+    unsigned char bin;
+
+    ibits_init(&in, buf, len);
+    dec.bits = &in;
+    dec.range = 510;
+    dec.offset = ibits_getbit(&in, 9);
+    for(i=0; i<n; i++)
+    {
+        if(bins[i].ctx < 0)
+            bin = ref_decodebypass(&dec);
+        else if(bins[i].ctx == NUM_CONTEXTS)
+            bin = ref_decodeterminate(&dec);
+        else
+            bin = ref_decodebin(&dec, &ctx[bins[i].ctx]);
+        bad |= bin != bins[i].bin;
+    }
+    return bad;
+}
+
+static int run(const char *name, int skewed)
+{
+    static T_Bin bins[NUM_FAIRBINS];
+    static unsigned char fastbuf[MAX_CODEC_BUFFER_LEN], refbuf[MAX_CODEC_BUFFER_LEN];
+    unsigned short fastlen, reflen;
+    double t, fastenc, fastdec, refenc, refdec;
+    int i, n, bad = 0;
+
+    n = skewed ? NUM_BINS : NUM_FAIRBINS;
+    makebins(bins, n, skewed);
+
+    fastlen = fastencode(bins, n, fastbuf);
+    reflen = refencode(bins, n, refbuf);
+    if(fastlen == 0 || reflen == 0)
+    {
+        printf("%s: encoded bins do not fit in %d bytes\n", name, MAX_CODEC_BUFFER_LEN);
+        return 1;
+    }
+
+    /*both coders must agree on every bin, the flush tails may differ*/
+    bad |= fastdecode(bins, n, fastbuf, (fastlen + 7) / 8);
+    bad |= refdecode(bins, n, fastbuf, (fastlen + 7) / 8);
+    bad |= fastdecode(bins, n, refbuf, (reflen + 7) / 8);
+    bad |= refdecode(bins, n, refbuf, (reflen + 7) / 8);
+    bad |= memcmp(fastbuf, refbuf, reflen / 8 - 2) != 0;
+    if(bad)
+    {
+        printf("%s: cabac mismatch against reference\n", name);
+        return 1;
+    }
+
+    t = now();
+    for(i=0; i<ROUNDS; i++)
+        fastencode(bins, n, fastbuf);
+    fastenc = now() - t;
+
+    t = now();
+    for(i=0; i<ROUNDS; i++)
+        bad |= fastdecode(bins, n, fastbuf, (fastlen + 7) / 8);
+    fastdec = now() - t;
+
+    t = now();
+    for(i=0; i<ROUNDS; i++)
+        refencode(bins, n, refbuf);
+    refenc = now() - t;
+
+    t = now();
+    for(i=0; i<ROUNDS; i++)
+        bad |= refdecode(bins, n, refbuf, (reflen + 7) / 8);
+    refdec = now() - t;
+
+    printf("%s: %d bins -> %u bits, %.2f bits/bin (reference %u bits)\n", name, n, fastlen, (double)fastlen / n, reflen);
+    printf("%-10s %12s %12s\n", "coder", "enc Mbin/s", "dec Mbin/s");
+    printf("%-10s %12.1f %12.1f\n", "cabac", n * (double)ROUNDS / fastenc / 1e6, n * (double)ROUNDS / fastdec / 1e6);
+    printf("%-10s %12.1f %12.1f\n", "reference", n * (double)ROUNDS / refenc / 1e6, n * (double)ROUNDS / refdec / 1e6);
+    printf("%-10s %11.2fx %11.2fx\n", "speedup", refenc / fastenc, refdec / fastdec);
+
+    return bad;
+}
+
+int main(void)
+{
+    int bad = 0;
+
+    srand(1);
+    bad |= run("skewed", 1);
+    bad |= run("equiprobable", 0);
+
+    return bad;
+}
@@ -0,0 +1,704 @@
+/*
+ * Microbenchmark of every ibits_/obits_/ibytes_/obytes_ primitive across
+ * field widths 1-32, starting bit alignments 0-7 and buffer sizes up to
+ * MAX_CODEC_BUFFER_LEN, reporting ns/op, cycles/op and bytes per second.
+ *
+ *   codec_bench [-csv] [-only name] [-time ms] [-compare base.csv [-threshold pct]]
+ *   codec_bench -check
+ *
+ * -csv writes one row per configuration so runs can be kept and diffed,
+ * -compare prints each row against a saved run and, with -threshold, fails
+ * when any configuration got slower by more than pct percent. -check
+ * verifies every primitive against a bit-by-bit model instead of timing.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "codec.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define CYCLES() __rdtsc()
+#else
+#define CYCLES() 0ULL
+#endif
+
+enum {
+    IBITS_GETBIT, IBITS_GETBYTE, IBITS_GETWORD, IBITS_GETDWORD, IBITS_FORWARD, IBITS_PEEK, IBITS_FINDPATTERN, IBITS_INIT,
+    OBITS_SETBIT, OBITS_SETBYTE, OBITS_SETWORD, OBITS_SETDWORD,
+    OBITS_SETBITBYPOS, OBITS_SETBYTEBYPOS, OBITS_SETWORDBYPOS, OBITS_SETDWORDBYPOS, OBITS_INIT,
+    IBYTES_GETBYTE, IBYTES_GETWORD, IBYTES_GETDWORD, IBYTES_FORWARD, IBYTES_BACK, IBYTES_INIT,
+    OBYTES_SETBYTE, OBYTES_SETWORD, OBYTES_SETDWORD, OBYTES_SETBYTESLICE,
+    OBYTES_SETBYTEBYPOS, OBYTES_SETWORDBYPOS, OBYTES_SETDWORDBYPOS, OBYTES_INIT,
+    NUM_PRIMITIVES
+};
+
+/*width 0 sweeps 1-32, aligned primitives only run at bit alignment 0*/
+typedef struct tagT_Primitive {
+    const char *name;
+    unsigned char width;
+    unsigned char aligned;
+} T_Primitive;
+
+static const T_Primitive primitives[NUM_PRIMITIVES] = {
+    {"ibits_getbit", 0, 0}, {"ibits_getbyte", 8, 0}, {"ibits_getword", 16, 0},
+    {"ibits_getdword", 32, 0}, {"ibits_forward", 0, 0}, {"ibits_peek", 0, 0},
+    {"ibits_findpattern", 16, 0}, {"ibits_init", 8, 1},
+    {"obits_setbit", 0, 0}, {"obits_setbyte", 8, 0}, {"obits_setword", 16, 0},
+    {"obits_setdword", 32, 0}, {"obits_setbitbypos", 0, 0}, {"obits_setbytebypos", 8, 0},
+    {"obits_setwordbypos", 16, 0}, {"obits_setdwordbypos", 32, 0}, {"obits_init", 8, 1},
+    {"ibytes_getbyte", 8, 1}, {"ibytes_getword", 16, 1}, {"ibytes_getdword", 32, 1},
+    {"ibytes_forward", 8, 1}, {"ibytes_back", 8, 1}, {"ibytes_init", 8, 1},
+    {"obytes_setbyte", 8, 1}, {"obytes_setword", 16, 1}, {"obytes_setdword", 32, 1},
+    {"obytes_setbyteslice", 8, 1}, {"obytes_setbytebypos", 8, 1}, {"obytes_setwordbypos", 16, 1},
+    {"obytes_setdwordbypos", 32, 1}, {"obytes_init", 8, 1}
+    };
+
+static const unsigned short buflens[] = {64, 512, MAX_CODEC_BUFFER_LEN};
+
+typedef struct tagT_Result {
+    char name[32];
+    unsigned int width, align, buflen;
+    double nsop, cycop, bytesps;
+} T_Result;
+
+static unsigned char inbuf[MAX_CODEC_BUFFER_LEN];
+static unsigned char outbuf[MAX_CODEC_BUFFER_LEN];
+static volatile unsigned int sink;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*one pass over the buffer, returns the number of primitive calls*/
+static unsigned long runpass(int prim, unsigned char w, unsigned char align, unsigned short len)
+{
+    T_InputBitStream ib;
+    T_OutputBitStream ob;
+    T_InputByteStream iy;
+    T_OutputByteStream oy;
+    unsigned int bits = 8 * len, s = 0, pos;
+    unsigned long n = 0;
+
+    ibits_init(&ib, inbuf, len);
+    /*init the outputs over nothing to keep the clearing out of the timing, then widen*/
+    obits_init(&ob, outbuf, 0);
+    ob.bits.totallen = len;
+    ob.bits.curbyte = align >> 3;
+    ob.bits.curbit = align;
+    ib.bits.curbit = align;
+    ibytes_init(&iy, inbuf, len);
+    obytes_init(&oy, outbuf, 0);
+    oy.bytes.totallen = len;
+
+    switch(prim)
+    {
+    case IBITS_GETBIT:
+        for(; bits - ib.bits.curbit >= w; n++)
+            s += ibits_getbit(&ib, w);
+        break;
+    case IBITS_GETBYTE:
+        for(; bits - ib.bits.curbit >= 8; n++)
+            s += ibits_getbyte(&ib);
+        break;
+    case IBITS_GETWORD:
+        for(; bits - ib.bits.curbit >= 16; n++)
+            s += ibits_getword(&ib);
+        break;
+    case IBITS_GETDWORD:
+        for(; bits - ib.bits.curbit >= 32; n++)
+            s += ibits_getdword(&ib);
+        break;
+    case IBITS_FORWARD:
+        for(; bits - ib.bits.curbit > w; n++)
+            ibits_forward(&ib, w);
+        break;
+    case IBITS_PEEK:
+        for(; bits - ib.bits.curbit > w; n++)
+        {
+            s += ibits_peek(&ib, w);
+            ibits_forward(&ib, w);
+        }
+        break;
+    case IBITS_FINDPATTERN:
+        /*w ones never occur in inbuf, so the call scans to the end*/
+        s += ibits_findpattern(&ib, ~0ULL, w, 0);
+        n = 1;
+        break;
+    case IBITS_INIT:
+        for(; n < 64; n++)
+            ibits_init(&ib, inbuf, len);
+        s += ib.bits.totallen;
+        break;
+    case OBITS_SETBIT:
+        for(; bits - ob.bits.curbit >= w; n++)
+            obits_setbit(&ob, w, (unsigned int)n);
+        break;
+    case OBITS_SETBYTE:
+        for(; bits - ob.bits.curbit >= 8; n++)
+            obits_setbyte(&ob, (unsigned char)n);
+        break;
+    case OBITS_SETWORD:
+        for(; bits - ob.bits.curbit >= 16; n++)
+            obits_setword(&ob, (unsigned short)n);
+        break;
+    case OBITS_SETDWORD:
+        for(; bits - ob.bits.curbit >= 32; n++)
+            obits_setdword(&ob, (unsigned int)n);
+        break;
+    case OBITS_SETBITBYPOS:
+        for(pos = align; pos + w <= bits; pos += w, n++)
+            obits_setbitbypos(&ob, (unsigned short)pos, w, (unsigned int)n);
+        break;
+    case OBITS_SETBYTEBYPOS:
+        for(pos = align; pos + 8 <= bits; pos += 8, n++)
+            obits_setbytebypos(&ob, (unsigned short)pos, (unsigned char)n);
+        break;
+    case OBITS_SETWORDBYPOS:
+        for(pos = align; pos + 16 <= bits; pos += 16, n++)
+            obits_setwordbypos(&ob, (unsigned short)pos, (unsigned short)n);
+        break;
+    case OBITS_SETDWORDBYPOS:
+        for(pos = align; pos + 32 <= bits; pos += 32, n++)
+            obits_setdwordbypos(&ob, (unsigned short)pos, (unsigned int)n);
+        break;
+    case OBITS_INIT:
+        for(; n < 64; n++)
+            obits_init(&ob, outbuf, len);
+        break;
+    case IBYTES_GETBYTE:
+        for(; len - iy.bytes.curbyte >= 1; n++)
+            s += ibytes_getbyte(&iy);
+        break;
+    case IBYTES_GETWORD:
+        for(; len - iy.bytes.curbyte >= 2; n++)
+            s += ibytes_getword(&iy);
+        break;
+    case IBYTES_GETDWORD:
+        for(; len - iy.bytes.curbyte >= 4; n++)
+            s += ibytes_getdword(&iy);
+        break;
+    case IBYTES_FORWARD:
+        for(; len - iy.bytes.curbyte > 1; n++)
+            ibytes_forward(&iy, 1);
+        break;
+    case IBYTES_BACK:
+        for(iy.bytes.curbyte = len - 1; iy.bytes.curbyte > 0; n++)
+            ibytes_back(&iy, 1);
+        break;
+    case IBYTES_INIT:
+        for(; n < 64; n++)
+            ibytes_init(&iy, inbuf, len);
+        s += iy.bytes.totallen;
+        break;
+    case OBYTES_SETBYTE:
+        for(; len - oy.bytes.curbyte >= 1; n++)
+            obytes_setbyte(&oy, (unsigned char)n);
+        break;
+    case OBYTES_SETWORD:
+        for(; len - oy.bytes.curbyte >= 2; n++)
+            obytes_setword(&oy, (unsigned short)n);
+        break;
+    case OBYTES_SETDWORD:
+        for(; len - oy.bytes.curbyte >= 4; n++)
+            obytes_setdword(&oy, (unsigned int)n);
+        break;
+    case OBYTES_SETBYTESLICE:
+        for(oy.bytes.curbyte = 1; n < len; n++)
+            obytes_setbyteslice(&oy, 6, 2, (unsigned char)n & 0x1f);
+        break;
+    case OBYTES_SETBYTEBYPOS:
+        for(pos = 0; pos + 1 <= len; pos += 1, n++)
+            obytes_setbytebypos(&oy, (unsigned short)pos, (unsigned char)n);
+        break;
+    case OBYTES_SETWORDBYPOS:
+        for(pos = 0; pos + 2 <= len; pos += 2, n++)
+            obytes_setwordbypos(&oy, (unsigned short)pos, (unsigned short)n);
+        break;
+    case OBYTES_SETDWORDBYPOS:
+        for(pos = 0; pos + 4 <= len; pos += 4, n++)
+            obytes_setdwordbypos(&oy, (unsigned short)pos, (unsigned int)n);
+        break;
+    case OBYTES_INIT:
+        for(; n < 64; n++)
+            obytes_init(&oy, outbuf, len);
+        break;
+    }
+
+    sink += s;
+    return n;
+}
+
+/*double the pass count until one batch runs for mintime, report that batch*/
+static void measure(int prim, unsigned char w, unsigned char align, unsigned short len, double mintime, T_Result *r)
+{
+    unsigned long passes = 1, i, ops;
+    unsigned long long c;
+    double t;
+    unsigned char bytes = primitives[prim].width ? primitives[prim].width / 8 : 0;
+
+    for(;;)
+    {
+        ops = 0;
+        t = now();
+        c = CYCLES();
+        for(i=0; i<passes; i++)
+            ops += runpass(prim, w, align, len);
+        c = CYCLES() - c;
+        t = now() - t;
+        if(t >= mintime || ops == 0)
+            break;
+        passes *= 2;
+    }
+
+    strncpy(r->name, primitives[prim].name, sizeof(r->name) - 1);
+    r->name[sizeof(r->name) - 1] = 0;
+    r->width = w;
+    r->align = align;
+    r->buflen = len;
+    r->nsop = ops ? t * 1e9 / ops : 0;
+    r->cycop = ops ? (double)c / ops : 0;
+    /*init and findpattern touch the whole buffer once per call*/
+    if(prim == IBITS_FINDPATTERN || prim == IBITS_INIT || prim == OBITS_INIT || prim == IBYTES_INIT || prim == OBYTES_INIT)
+        r->bytesps = t > 0 ? (double)ops * len / t : 0;
+    else
+        r->bytesps = t > 0 ? ops * (bytes ? bytes : w / 8.0) / t : 0;
+}
+
+/*rows of the full sweep, one per primitive, width, alignment and buffer size*/
+static int sweepsize(void)
+{
+    int prim, n = 0;
+
+    for(prim=0; prim<NUM_PRIMITIVES; prim++)
+        n += (primitives[prim].width ? 1 : 32) * (primitives[prim].aligned ? 1 : 8);
+
+    return n * (int)(sizeof(buflens)/sizeof(buflens[0]));
+}
+
+/*-1 when the file cannot be read or has more rows than max*/
+static int loadcsv(const char *path, T_Result *rows, int max)
+{
+    FILE *f = fopen(path, "r");
+    char line[256];
+    T_Result r;
+    int n = 0;
+
+    if(f == NULL)
+        return -1;
+
+    while(fgets(line, sizeof(line), f))
+    {
+        if(sscanf(line, "%31[^,],%u,%u,%u,%lf,%lf,%lf", r.name, &r.width, &r.align,
+                  &r.buflen, &r.nsop, &r.cycop, &r.bytesps) != 7)
+            continue;
+        if(n == max)
+        {
+            n = -1;
+            break;
+        }
+        rows[n++] = r;
+    }
+
+    fclose(f);
+    return n;
+}
+
+/*model of bit k in the given order*/
+static unsigned int modelbit(const unsigned char *msg, unsigned int k, unsigned short order)
+{
+    if(order == CODEC_LSB_FIRST)
+        return (msg[k >> 3] >> (k & 7)) & 1;
+    return (msg[k >> 3] >> (7 - (k & 7))) & 1;
+}
+
+static unsigned int modelfield(const unsigned char *msg, unsigned int pos, unsigned char w, unsigned short order)
+{
+    unsigned int v = 0, i;
+
+    for(i=0; i<w; i++)
+    {
+        if(order == CODEC_LSB_FIRST)
+            v |= modelbit(msg, pos + i, order) << i;
+        else
+            v = (v << 1) | modelbit(msg, pos + i, order);
+    }
+    return v;
+}
+
+static unsigned long long modelfield64(const unsigned char *msg, unsigned int pos, unsigned char w, unsigned short order)
+{
+    unsigned long long v = 0;
+    unsigned int i;
+
+    for(i=0; i<w; i++)
+    {
+        if(order == CODEC_LSB_FIRST)
+            v |= (unsigned long long)modelbit(msg, pos + i, order) << i;
+        else
+            v = (v << 1) | modelbit(msg, pos + i, order);
+    }
+    return v;
+}
+
+/*first position from start whose w bits are within maxerrors of pattern, tried one by one*/
+static unsigned short modelfind(const unsigned char *msg, unsigned int bits, unsigned int start,
+                                unsigned long long pattern, unsigned char w, unsigned char maxerrors, unsigned short order)
+{
+    unsigned long long diff, mask = w == 64 ? ~0ULL : (1ULL << w) - 1;
+    unsigned int pos, errors;
+
+    for(pos = start; pos + w <= bits; pos++)
+    {
+        diff = (modelfield64(msg, pos, w, order) ^ pattern) & mask;
+        for(errors = 0; diff; diff &= diff - 1)
+            errors ++;
+        if(errors <= maxerrors)
+            return (unsigned short)pos;
+    }
+    return CODEC_NOPOS;
+}
+
+static int check(void)
+{
+    T_InputBitStream ib;
+    T_OutputBitStream ob;
+    T_InputByteStream iy;
+    T_OutputByteStream oy;
+    T_BitMark mark;
+    unsigned int values[MAX_CODEC_BUFFER_LEN], v, pos, i, n;
+    unsigned short len = 512, order;
+    unsigned char w, align;
+    int fails = 0;
+
+    srand(7);
+    for(i=0; i<len; i++)
+        inbuf[i] = (unsigned char)rand();
+
+    for(order = CODEC_MSB_FIRST; order <= CODEC_LSB_FIRST; order++)
+    {
+        for(w = 1; w <= 32; w++)
+        {
+            for(align = 0; align < 8; align++)
+            {
+                unsigned int mask = w == 32 ? 0xffffffff : (1u << w) - 1;
+
+                /*getbit against the model*/
+                ibits_init(&ib, inbuf, len);
+                ibits_setorder(&ib, order);
+                if(align)
+                    ibits_forward(&ib, align);
+                for(pos = align; pos + w <= 8u * len; pos += w)
+                    fails += ibits_getbit(&ib, w) != modelfield(inbuf, pos, w, order);
+                fails += ibits_geterror(&ib) != CODEC_OK;
+
+                /*peek at every field from the end back, then reread the last after a restore*/
+                ibits_save(&ib, &mark);
+                fails += ibits_peek(&ib, w) != 0;
+                for(i = pos; i >= align + w; i -= w)
+                {
+                    ibits_back(&ib, w);
+                    fails += ibits_getcurpos(&ib) != i - w;
+                    fails += ibits_peek(&ib, w) != modelfield(inbuf, i - w, w, order);
+                }
+                fails += ibits_peek(&ib, 0) != 0 || ibits_geterror(&ib) != CODEC_OK;
+                ibits_back(&ib, 8 * len);
+                fails += ibits_geterror(&ib) != CODEC_MOVETOOBITS;
+                ibits_restore(&ib, &mark);
+                ibits_back(&ib, w);
+                fails += ibits_getbit(&ib, w) != modelfield(inbuf, pos - w, w, order);
+                fails += ibits_geterror(&ib) != CODEC_OK || ibits_getcurpos(&ib) != pos;
+
+                /*setbit then read back through the model*/
+                obits_init(&ob, outbuf, len);
+                obits_setorder(&ob, order);
+                if(align)
+                    obits_setbit(&ob, align, 0);
+                for(n = 0, pos = align; pos + w <= 8u * len; pos += w, n++)
+                {
+                    values[n] = ((unsigned int)rand() << 16 ^ (unsigned int)rand()) & mask;
+                    obits_setbit(&ob, w, values[n]);
+                }
+                for(i = 0, pos = align; i < n; i++, pos += w)
+                    fails += modelfield(outbuf, pos, w, order) != values[i];
+                fails += obits_geterror(&ob) != CODEC_OK || obits_getlen(&ob) != pos;
+
+                /*setbitbypos into a fresh buffer*/
+                obits_init(&ob, outbuf, len);
+                obits_setorder(&ob, order);
+                for(i = 0, pos = align; i < n; i++, pos += w)
+                    obits_setbitbypos(&ob, (unsigned short)pos, w, values[i]);
+                for(i = 0, pos = align; i < n; i++, pos += w)
+                    fails += modelfield(outbuf, pos, w, order) != values[i];
+            }
+        }
+
+        /*fixed-width bit accessors at every alignment*/
+        for(align = 0; align < 8; align++)
+        {
+            obits_init(&ob, outbuf, len);
+            obits_setorder(&ob, order);
+            obits_setbytebypos(&ob, align, 0xa5);
+            obits_setwordbypos(&ob, align + 8, 0xbeef);
+            obits_setdwordbypos(&ob, align + 24, 0x12345678);
+            ibits_init(&ib, outbuf, len);
+            ibits_setorder(&ib, order);
+            if(align)
+                ibits_forward(&ib, align);
+            fails += ibits_getbyte(&ib) != 0xa5;
+            fails += ibits_getword(&ib) != 0xbeef;
+            fails += ibits_getdword(&ib) != 0x12345678;
+        }
+    }
+
+    /*
+     * findpattern against the one-by-one search, from random starts, for
+     * patterns cut from the buffer with up to maxerrors + 1 bits flipped
+     * and garbage above the width, in a 64-byte buffer
+     */
+    for(order = CODEC_MSB_FIRST; order <= CODEC_LSB_FIRST; order++)
+    {
+        unsigned int found = 0, straddling = 0, inexact = 0;
+        unsigned long long pattern;
+        unsigned short expect, got;
+        unsigned char maxerrors;
+
+        for(i = 0; i < 4000; i++)
+        {
+            w = (unsigned char)(1 + rand() % 64);
+            maxerrors = (unsigned char)(rand() % 4);
+            pos = (unsigned int)rand() % (512 - w + 1);
+            pattern = modelfield64(inbuf, pos, w, order);
+            for(n = rand() % (maxerrors + 2); n > 0; n--)
+                pattern ^= 1ULL << (rand() % w);
+            if(w < 64)
+                pattern |= (unsigned long long)rand() << w;
+            pos = i % 3 ? (unsigned int)rand() % (pos + 1) : (unsigned int)rand() % 512;
+
+            ibits_init(&ib, inbuf, 64);
+            ibits_setorder(&ib, order);
+            if(pos)
+                ibits_forward(&ib, pos);
+            expect = modelfind(inbuf, 512, pos, pattern, w, maxerrors, order);
+            got = ibits_findpattern(&ib, pattern, w, maxerrors);
+            fails += got != expect || ibits_geterror(&ib) != CODEC_OK;
+            fails += ibits_getcurpos(&ib) != (expect == CODEC_NOPOS ? pos : expect);
+            if(expect != CODEC_NOPOS)
+            {
+                found ++;
+                straddling += expect / 8 != (expect + w - 1u) / 8;
+                inexact += modelfield64(inbuf, expect, w, order) != (w == 64 ? pattern : pattern & ((1ULL << w) - 1));
+                fails += modelfield(inbuf, expect, w < 32 ? w : 32, order) != ibits_getbit(&ib, w < 32 ? w : 32);
+            }
+        }
+        fails += found < 1000 || straddling < 500 || inexact < 200 || found == i;
+
+        ibits_init(&ib, inbuf, 64);
+        fails += ibits_findpattern(&ib, 0, 0, 0) != CODEC_NOPOS || ibits_geterror(&ib) != CODEC_GETZEROBITS;
+        ibits_init(&ib, inbuf, 64);
+        fails += ibits_findpattern(&ib, 0, 65, 0) != CODEC_NOPOS || ibits_geterror(&ib) != CODEC_GETTOOBITS;
+    }
+
+    /*byte streams in both word orders*/
+    for(order = CODEC_BIG_ENDIAN; order <= CODEC_LITTLE_ENDIAN; order++)
+    {
+        obytes_init(&oy, outbuf, 16);
+        obytes_setorder(&oy, order);
+        obytes_setbyte(&oy, 0x11);
+        obytes_setword(&oy, 0x2233);
+        obytes_setdword(&oy, 0x44556677);
+        obytes_setbyteslice(&oy, 3, 0, 0x9);
+        obytes_setwordbypos(&oy, 8, 0x8899);
+        obytes_setdwordbypos(&oy, 10, 0xaabbccdd);
+        fails += obytes_getlen(&oy) != 7 || obytes_geterror(&oy) != CODEC_OK;
+        if(order == CODEC_BIG_ENDIAN)
+            fails += outbuf[1] != 0x22 || outbuf[3] != 0x44 || outbuf[8] != 0x88 || outbuf[10] != 0xaa;
+        else
+            fails += outbuf[1] != 0x33 || outbuf[3] != 0x77 || outbuf[8] != 0x99 || outbuf[10] != 0xdd;
+
+        ibytes_init(&iy, outbuf, 16);
+        ibytes_setorder(&iy, order);
+        fails += ibytes_getbyte(&iy) != 0x11;
+        fails += ibytes_getword(&iy) != 0x2233;
+        v = ibytes_getdword(&iy);
+        fails += (v & 0xfffffff0) != 0x44556670 && (v & 0xf0ffffff) != 0x40556677;
+        ibytes_forward(&iy, 1);
+        fails += ibytes_getword(&iy) != 0x8899;
+        fails += ibytes_getdword(&iy) != 0xaabbccdd;
+        ibytes_back(&iy, 4);
+        fails += ibytes_getcurpos(&iy) != 10 || ibytes_geterror(&iy) != CODEC_OK;
+        ibytes_getdword(&iy);
+        ibytes_getdword(&iy);
+        fails += ibytes_geterror(&iy) != CODEC_GETTOOBITS;
+    }
+
+    /*counting streams move and fail exactly like real ones*/
+    for(order = CODEC_MSB_FIRST; order <= CODEC_LSB_FIRST; order++)
+    {
+        for(w = 1; w <= 32; w++)
+        {
+            T_OutputBitStream cb;
+
+            obits_init(&ob, outbuf, 64);
+            obits_init(&cb, NULL, 64);
+            obits_setorder(&ob, order);
+            obits_setorder(&cb, order);
+            for(i = 0; i < 520u / w + 1; i++)
+            {
+                v = (unsigned int)rand();
+                obits_setbit(&ob, w, v);
+                obits_setbit(&cb, w, v);
+                obits_setbitbypos(&ob, (unsigned short)(i % 64), w, v);
+                obits_setbitbypos(&cb, (unsigned short)(i % 64), w, v);
+                fails += obits_getlen(&cb) != obits_getlen(&ob) || obits_geterror(&cb) != obits_geterror(&ob);
+            }
+            fails += obits_geterror(&cb) != CODEC_SETTOOBITS || obits_getbuf(&cb) != NULL;
+        }
+    }
+    for(order = CODEC_BIG_ENDIAN; order <= CODEC_LITTLE_ENDIAN; order++)
+    {
+        T_OutputByteStream cy;
+
+        obytes_init(&oy, outbuf, 15);
+        obytes_init(&cy, NULL, 15);
+        obytes_setorder(&oy, order);
+        obytes_setorder(&cy, order);
+        for(i = 0; i < 4; i++)
+        {
+            obytes_setbyte(&oy, 1);
+            obytes_setbyte(&cy, 1);
+            obytes_setbyteslice(&oy, 3, 0, 9);
+            obytes_setbyteslice(&cy, 3, 0, 9);
+            obytes_setword(&oy, 2);
+            obytes_setword(&cy, 2);
+            obytes_setdwordbypos(&oy, 11, 3);
+            obytes_setdwordbypos(&cy, 11, 3);
+            obytes_setdword(&oy, 4);
+            obytes_setdword(&cy, 4);
+            fails += obytes_getlen(&cy) != obytes_getlen(&oy) || obytes_geterror(&cy) != obytes_geterror(&oy);
+        }
+        fails += obytes_geterror(&cy) != CODEC_SETTOOBITS || obytes_getbuf(&cy) != NULL;
+    }
+
+    printf("check: %d failures\n", fails);
+    return fails != 0;
+}
+
+int main(int argc, char **argv)
+{
+    T_Result *results, *base;
+    const char *only = NULL, *compare = NULL;
+    double mintime = 0.002, threshold = -1, delta;
+    int csv = 0, nres = 0, nbase = 0, slower = 0, maxres = sweepsize();
+    int prim, l, i, j;
+    unsigned char w, wlo, whi, align, alignmax;
+
+    for(i=1; i<argc; i++)
+    {
+        if(!strcmp(argv[i], "-check"))
+            return check();
+        else if(!strcmp(argv[i], "-csv"))
+            csv = 1;
+        else if(!strcmp(argv[i], "-only") && i + 1 < argc)
+            only = argv[++i];
+        else if(!strcmp(argv[i], "-time") && i + 1 < argc)
+            mintime = atof(argv[++i]) / 1000;
+        else if(!strcmp(argv[i], "-compare") && i + 1 < argc)
+            compare = argv[++i];
+        else if(!strcmp(argv[i], "-threshold") && i + 1 < argc)
+            threshold = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "usage: %s [-csv] [-only name] [-time ms] [-compare base.csv [-threshold pct]] | -check\n", argv[0]);
+            return 2;
+        }
+    }
+
+    results = malloc(maxres * sizeof(*results));
+    base = malloc(maxres * sizeof(*base));
+    if(results == NULL || base == NULL)
+        abort();
+
+    if(compare && (nbase = loadcsv(compare, base, maxres)) < 0)
+    {
+        fprintf(stderr, "cannot read %s, or it has more than the %d rows of a sweep\n", compare, maxres);
+        return 2;
+    }
+
+    for(i=0; i<MAX_CODEC_BUFFER_LEN; i++)
+        inbuf[i] = (unsigned char)(i * 131 + 7);
+
+    if(csv)
+        printf("primitive,width,align,buflen,ns_per_op,cycles_per_op,bytes_per_sec\n");
+    else if(compare)
+        printf("%-22s %5s %5s %6s %10s %10s %8s\n", "primitive", "width", "align", "buflen", "ns/op", "base", "delta");
+    else
+        printf("%-22s %5s %5s %6s %10s %10s %12s\n", "primitive", "width", "align", "buflen", "ns/op", "cycles/op", "MB/s");
+
+    for(prim=0; prim<NUM_PRIMITIVES; prim++)
+    {
+        if(only && strcmp(only, primitives[prim].name))
+            continue;
+
+        wlo = primitives[prim].width ? primitives[prim].width : 1;
+        whi = primitives[prim].width ? primitives[prim].width : 32;
+        alignmax = primitives[prim].aligned ? 1 : 8;
+        for(l=0; l<(int)(sizeof(buflens)/sizeof(buflens[0])); l++)
+        for(w=wlo; w<=whi; w++)
+        for(align=0; align<alignmax; align++)
+        {
+            T_Result *r;
+
+            if(nres == maxres)
+            {
+                fprintf(stderr, "sweep has more than the %d configurations of sweepsize\n", maxres);
+                return 2;
+            }
+            r = &results[nres++];
+            measure(prim, w, align, buflens[l], mintime, r);
+
+            if(csv)
+            {
+                printf("%s,%u,%u,%u,%.3f,%.2f,%.0f\n", r->name, r->width, r->align, r->buflen, r->nsop, r->cycop, r->bytesps);
+                continue;
+            }
+
+            if(!compare)
+            {
+                printf("%-22s %5u %5u %6u %10.2f %10.1f %12.1f\n", r->name, r->width, r->align, r->buflen, r->nsop, r->cycop, r->bytesps / 1e6);
+                continue;
+            }
+
+            for(j=0; j<nbase; j++)
+            {
+                if(!strcmp(base[j].name, r->name) && base[j].width == r->width && base[j].align == r->align && base[j].buflen == r->buflen)
+                    break;
+            }
+            if(j == nbase || base[j].nsop <= 0)
+            {
+                printf("%-22s %5u %5u %6u %10.2f %10s %8s\n", r->name, r->width, r->align, r->buflen, r->nsop, "-", "-");
+                continue;
+            }
+
+            delta = (r->nsop - base[j].nsop) * 100 / base[j].nsop;
+            if(threshold >= 0 && delta > threshold)
+                slower ++;
+            printf("%-22s %5u %5u %6u %10.2f %10.2f %+7.1f%%\n", r->name, r->width, r->align, r->buflen, r->nsop, base[j].nsop, delta);
+        }
+    }
+
+    free(results);
+    free(base);
+
+    if(slower)
+    {
+        printf("%d configurations slower than %.1f%%\n", slower, threshold);
+        return 1;
+    }
+
+    return 0;
+}
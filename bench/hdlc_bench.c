@@ -0,0 +1,379 @@
+/*
+ * Payload Mbit/s of the table-driven HDLC stuffing and destuffing in hdlc.c
+ * against a bit-serial reference on obits_setbit/ibits_getbit of single
+ * bits. A wire buffer of random, all-ones and all-flag frames is encoded
+ * in both bit orders and must match the reference bit for bit, then is
+ * decoded whole, a byte per call and in random pieces so frames span input
+ * buffers. Hand-written bit strings cover shared flags, stuffed zeros next
+ * to flags, aborts, idle ones, empty frames and output overflow.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "hdlc.h"
+
+#define MAX_FRAMES   64
+#define MAX_PAYLOAD  200       /*bytes*/
+#define ROUNDS       2000
+
+static unsigned char payload[MAX_FRAMES][MAX_PAYLOAD];
+static unsigned short lens[MAX_FRAMES];   /*bits*/
+static unsigned int nframes;
+static unsigned char wire[MAX_CODEC_BUFFER_LEN];
+static unsigned char refwire[MAX_CODEC_BUFFER_LEN];
+static unsigned short wirelen;            /*bytes*/
+static unsigned char frame[MAX_CODEC_BUFFER_LEN];
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*the first n bits of a and b, in the bit order they were written in*/
+static int samebits(const unsigned char *a, const unsigned char *b, unsigned int n, unsigned short order)
+{
+    unsigned char mask;
+
+    if(memcmp(a, b, n / 8))
+        return 0;
+    if(n % 8 == 0)
+        return 1;
+
+    mask = order == CODEC_LSB_FIRST ? (unsigned char)(0xFF >> (8 - n % 8)) : (unsigned char)(0xFF << (8 - n % 8));
+    return ((a[n / 8] ^ b[n / 8]) & mask) == 0;
+}
+
+/*the bit-serial stuffing hdlc_encodeframe replaces*/
+static void refencode(T_InputBitStream *in, unsigned int n, T_OutputBitStream *out)
+{
+    unsigned int i, ones = 0;
+    unsigned char b;
+
+    for(i = 0; i < 8; i++)
+        obits_setbit(out, 1, (HDLC_FLAG >> (7 - i)) & 1);
+    for(; n > 0; n--)
+    {
+        b = (unsigned char)ibits_getbit(in, 1);
+        obits_setbit(out, 1, b);
+        ones = b ? ones + 1 : 0;
+        if(ones == 5)
+        {
+            obits_setbit(out, 1, 0);
+            ones = 0;
+        }
+    }
+    for(i = 0; i < 8; i++)
+        obits_setbit(out, 1, (HDLC_FLAG >> (7 - i)) & 1);
+}
+
+/*
+ * Bit-serial destuffing into out, returning the frames seen. Each bit is
+ * written six bits late, so a closing flag's zero and ones are never
+ * written and frames are just restarted.
+ */
+static unsigned int refdecode(T_InputBitStream *in, T_OutputBitStream *out)
+{
+    unsigned int i, ones = 0, open = 0, pending = 0, held = 0, frames = 0;
+    unsigned char b;
+
+    for(i = 8 * in->bits.totallen - in->bits.curbit; i > 0; i--)
+    {
+        b = (unsigned char)ibits_getbit(in, 1);
+        if(b && ++ones >= 6)
+        {
+            if(ones == 7)
+                open = 0;
+            continue;
+        }
+        if(!b && ones == 6)
+        {
+            if(open && obits_getlen(out) > 0)
+                frames++;
+            obits_init(out, out->bits.buffer, out->bits.totallen);
+            open = 1;
+            held = pending = ones = 0;
+            continue;
+        }
+        if(!b && ones == 5)
+        {
+            ones = 0;
+            continue;
+        }
+        ones = b ? ones : 0;
+        if(held == 6)
+            obits_setbit(out, 1, (pending >> 5) & 1);
+        else
+            held++;
+        pending = (pending << 1 | b) & 0x3F;
+    }
+
+    return frames;
+}
+
+static void makeframes(void)
+{
+    unsigned int i, k, kind;
+
+    for(i = 0; i < MAX_FRAMES; i++)
+    {
+        kind = rand() % 4;
+        lens[i] = (unsigned short)(1 + rand() % (8 * MAX_PAYLOAD));
+        for(k = 0; k < MAX_PAYLOAD; k++)
+        {
+            if(kind == 0)
+                payload[i][k] = (unsigned char)rand();
+            else if(kind == 1)
+                payload[i][k] = 0xFF;
+            else if(kind == 2)
+                payload[i][k] = HDLC_FLAG;
+            else
+                payload[i][k] = (unsigned char)(rand() % 8 == 0 ? 0xF8 >> rand() % 4 : 0);
+        }
+    }
+}
+
+/*as many frames as fit, then ones to the end of the buffer (an idle line)*/
+static unsigned long makewire(unsigned short order)
+{
+    T_OutputBitStream out, ref;
+    T_InputBitStream in;
+    unsigned long bad = 0;
+
+    obits_init(&out, wire, sizeof(wire));
+    obits_init(&ref, refwire, sizeof(refwire));
+    obits_setorder(&out, order);
+    obits_setorder(&ref, order);
+    for(nframes = 0; nframes < MAX_FRAMES; nframes++)
+    {
+        /*stuffing adds at most one bit in five, keep a byte of idle ones*/
+        if(obits_getlen(&out) + lens[nframes] + lens[nframes] / 5 + 16u + 16u > 8 * sizeof(wire))
+            break;
+        ibits_init(&in, payload[nframes], MAX_PAYLOAD);
+        ibits_setorder(&in, order);
+        bad += hdlc_encodeframe(&in, lens[nframes], &out) != CODEC_OK;
+        bad += ibits_getlen(&in) != lens[nframes];
+        ibits_init(&in, payload[nframes], MAX_PAYLOAD);
+        ibits_setorder(&in, order);
+        refencode(&in, lens[nframes], &ref);
+    }
+
+    bad += obits_getlen(&out) != obits_getlen(&ref) || !samebits(wire, refwire, obits_getlen(&out), order);
+    while(obits_getlen(&out) % 8 != 0)
+        obits_setbit(&out, 1, 1);
+    while(obits_getlen(&out) < 8 * sizeof(wire))
+        obits_setbit(&out, 8, 0xFF);
+    wirelen = sizeof(wire);
+
+    return bad;
+}
+
+/*piece 0 decodes the wire in one call, otherwise in pieces of at most that many bytes*/
+static unsigned long decodewire(unsigned short order, unsigned int piece, int randomly)
+{
+    T_HdlcDecoder dec;
+    T_InputBitStream in;
+    T_OutputBitStream out;
+    unsigned long bad = 0;
+    unsigned int off, len, k = 0;
+    unsigned short r;
+
+    hdlc_decoderinit(&dec);
+    obits_init(&out, frame, sizeof(frame));
+    obits_setorder(&out, order);
+    for(off = 0; off < wirelen; off += len)
+    {
+        len = piece == 0 ? wirelen : randomly ? 1 + rand() % piece : piece;
+        len = len < wirelen - off ? len : wirelen - off;
+        ibits_init(&in, wire + off, (unsigned short)len);
+        ibits_setorder(&in, order);
+        while((r = hdlc_decodeframe(&dec, &in, &out)) != HDLC_NEEDMORE)
+        {
+            if(r != HDLC_FRAME || k >= nframes)
+                bad++;
+            else
+                bad += obits_getlen(&out) != lens[k] || !samebits(frame, payload[k], lens[k], order);
+            k++;
+            obits_init(&out, frame, sizeof(frame));
+            obits_setorder(&out, order);
+        }
+    }
+
+    return bad + (k != nframes);
+}
+
+/*
+ * Decodes a string of '0' and '1' with 'F' for a flag and spaces ignored,
+ * into an output stream of outlen bytes. The results must read as expect:
+ * 'A' for an abort, 'O' for an overflow and 'F' followed by the frame bits
+ * for a frame, space separated.
+ */
+static unsigned long edgecase(const char *bits, unsigned short outlen, const char *expect, unsigned short order)
+{
+    static unsigned char buf[64];
+    char got[256], *g = got;
+    T_HdlcDecoder dec;
+    T_InputBitStream in;
+    T_OutputBitStream out;
+    const char *p;
+    unsigned int i;
+    unsigned short r;
+
+    obits_init(&out, buf, sizeof(buf));
+    obits_setorder(&out, order);
+    for(p = bits; *p; p++)
+    {
+        if(*p == 'F')
+            obits_setbit(&out, 8, HDLC_FLAG);
+        else if(*p != ' ')
+            obits_setbit(&out, 1, *p == '1');
+    }
+    while(obits_getlen(&out) % 8 != 0)
+        obits_setbit(&out, 1, 1);
+
+    hdlc_decoderinit(&dec);
+    ibits_init(&in, buf, obits_getlen(&out) / 8);
+    ibits_setorder(&in, order);
+    obits_init(&out, frame, outlen);
+    obits_setorder(&out, order);
+    while((r = hdlc_decodeframe(&dec, &in, &out)) != HDLC_NEEDMORE)
+    {
+        if(g != got)
+            *g++ = ' ';
+        *g++ = r == HDLC_FRAME ? 'F' : r == HDLC_ABORT ? 'A' : r == HDLC_OVERFLOW ? 'O' : '?';
+        if(r == HDLC_FRAME)
+        {
+            T_InputBitStream f;
+
+            ibits_init(&f, frame, outlen);
+            ibits_setorder(&f, order);
+            for(i = obits_getlen(&out); i > 0 && g < got + sizeof(got) - 2; i--)
+                *g++ = ibits_getbit(&f, 1) ? '1' : '0';
+        }
+        obits_init(&out, frame, outlen);
+        obits_setorder(&out, order);
+    }
+    *g = 0;
+
+    if(strcmp(got, expect) == 0)
+        return 0;
+    printf("%s first: \"%s\" gave \"%s\", expected \"%s\"\n", order == CODEC_LSB_FIRST ? "LSB" : "MSB", bits, got, expect);
+    return 1;
+}
+
+static unsigned long edgecases(unsigned short order)
+{
+    T_InputBitStream in;
+    T_OutputBitStream out;
+    unsigned long bad = 0;
+
+    bad += edgecase("F 1011 F", 64, "F1011", order);
+    bad += edgecase("1111111111 F 1011 F 0110 F", 64, "F1011 F0110", order);           /*one flag between frames*/
+    bad += edgecase("F F F 1111110 1111110 101 F F", 64, "F101", order);              /*idle flags, some sharing a zero*/
+    bad += edgecase("F 111110 1 F", 64, "F111111", order);                           /*stuffed zero*/
+    bad += edgecase("F 0 111110 F", 64, "F011111", order);                           /*stuffed zero against the flag*/
+    bad += edgecase("F 111110 111110 F", 64, "F1111111111", order);
+    bad += edgecase("F 10110 1111111 F 01 F", 64, "A F01", order);                   /*abort, then a new frame*/
+    bad += edgecase("F 1111111 F 01 F", 64, "F01", order);                           /*abort of nothing is not reported*/
+    bad += edgecase("F 1 F 111111111111111 F 0 F", 64, "F1 F0", order);              /*idle ones after a frame*/
+    bad += edgecase("F 1111111 1111111 0 F", 64, "", order);
+    bad += edgecase("F 1 F 1111110", 64, "F1", order);                               /*a flag sharing the last zero*/
+    bad += edgecase("F 1 F 1111110 0", 64, "F1 A", order);                           /*a zero, then idle ones*/
+    bad += edgecase("F 1010101010 1010101010 1010101010 1010101010 F 1 F", 4, "O F1", order);
+    bad += edgecase("F 1010101010 1010101010 1010101010 101 F 0 F", 4, "O F0", order);           /*one bit too many*/
+    bad += edgecase("F 1010101010 1010101010 1010101010 10 F", 4, "F10101010101010101010101010101010", order);  /*exactly fills*/
+    bad += edgecase("F 1111011110 1111011110 1111011110 11 F", 4, "F11110111101111011110111101111011", order);
+
+    /*an encoded frame that does not fit, and input that runs out*/
+    ibits_init(&in, payload[0], MAX_PAYLOAD);
+    obits_init(&out, frame, 4);
+    bad += hdlc_encodeframe(&in, 40, &out) != CODEC_SETTOOBITS;
+    ibits_init(&in, payload[0], 2);
+    obits_init(&out, frame, sizeof(frame));
+    bad += hdlc_stuff(&in, 17, &out) != CODEC_GETTOOBITS;
+
+    return bad;
+}
+
+int main(void)
+{
+    T_HdlcDecoder dec;
+    T_InputBitStream in;
+    T_OutputBitStream out;
+    unsigned long bad = 0, bits;
+    unsigned short order;
+    unsigned int i, r, n;
+    double tref, tenc, trefdec, tdec;
+
+    srand(5);
+    makeframes();
+    for(order = CODEC_MSB_FIRST; order <= CODEC_LSB_FIRST; order++)
+    {
+        bad += edgecases(order);
+        bad += makewire(order);
+        bad += decodewire(order, 0, 0);
+        bad += decodewire(order, 1, 0);
+        for(r = 0; r < 20; r++)
+            bad += decodewire(order, 64, 1);
+    }
+
+    /*timing in MSB-first order, over the wire left by the last makewire*/
+    order = CODEC_MSB_FIRST;
+    bad += makewire(order);
+    for(i = 0, bits = 0; i < nframes; i++)
+        bits += lens[i];
+
+    tref = now();
+    for(r = 0; r < ROUNDS; r++)
+    {
+        obits_init(&out, refwire, sizeof(refwire));
+        for(i = 0; i < nframes; i++)
+        {
+            ibits_init(&in, payload[i], MAX_PAYLOAD);
+            refencode(&in, lens[i], &out);
+        }
+    }
+    tref = now() - tref;
+
+    tenc = now();
+    for(r = 0; r < ROUNDS; r++)
+    {
+        obits_init(&out, refwire, sizeof(refwire));
+        for(i = 0; i < nframes; i++)
+        {
+            ibits_init(&in, payload[i], MAX_PAYLOAD);
+            hdlc_encodeframe(&in, lens[i], &out);
+        }
+    }
+    tenc = now() - tenc;
+
+    trefdec = now();
+    for(r = 0; r < ROUNDS; r++)
+    {
+        ibits_init(&in, wire, wirelen);
+        obits_init(&out, frame, sizeof(frame));
+        bad += refdecode(&in, &out) != nframes;
+    }
+    trefdec = now() - trefdec;
+
+    tdec = now();
+    for(r = 0; r < ROUNDS; r++)
+    {
+        hdlc_decoderinit(&dec);
+        ibits_init(&in, wire, wirelen);
+        obits_init(&out, frame, sizeof(frame));
+        for(n = 0; hdlc_decodeframe(&dec, &in, &out) == HDLC_FRAME; n++)
+            obits_init(&out, frame, sizeof(frame));
+        bad += n != nframes;
+    }
+    tdec = now() - tdec;
+
+    printf("%u frames, %lu payload bits, %u wire bytes\n", nframes, bits, wirelen);
+    printf("stuff   reference %6.0f Mbit/s  hdlc %6.0f Mbit/s\n", 1e-6 * ROUNDS * bits / tref, 1e-6 * ROUNDS * bits / tenc);
+    printf("destuff reference %6.0f Mbit/s  hdlc %6.0f Mbit/s\n", 1e-6 * ROUNDS * bits / trefdec, 1e-6 * ROUNDS * bits / tdec);
+
+    printf("%lu bad\n", bad);
+    return bad != 0;
+}
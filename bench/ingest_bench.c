@@ -0,0 +1,231 @@
+/*
+ * Throughput of decoding straight out of the ingest pool, with io_uring
+ * reads running under the decode, against the blocking read path. The
+ * sources are a temporary file of fixed-size records, dropped from the
+ * page cache before each run where the kernel allows, and a
+ * SOCK_SEQPACKET socketpair fed by a writer thread. Every record is
+ * checked for order and content.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include "ingest.h"
+
+#define RECLEN       MAX_CODEC_BUFFER_LEN
+#define NUM_RECORDS  8192          /*32 MB file*/
+#define NUM_PACKETS  100000
+#define SLOTS        64
+#define BATCH        16
+
+typedef struct tagT_Run {
+    unsigned long records, bytes, bad;
+    double seconds;
+} T_Run;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static unsigned int pattern(unsigned int seq, unsigned int i)
+{
+    return (seq * 2654435761u) ^ (i * 40503u);
+}
+
+/*record seq: its number then words of the pattern, len a multiple of 4*/
+static void fill(unsigned char *buf, unsigned int seq, unsigned short len)
+{
+    T_OutputByteStream out;
+    unsigned short i;
+
+    obytes_init(&out, buf, len);
+    obytes_setdword(&out, seq);
+    for(i = 4; i + 4 <= len; i += 4)
+        obytes_setdword(&out, pattern(seq, i));
+}
+
+static int check(T_InputByteStream *in, unsigned int seq)
+{
+    unsigned short i, len = in->bytes.totallen;
+    int bad = ibytes_getdword(in) != seq;
+
+    for(i = 4; i + 4 <= len; i += 4)
+        bad |= ibytes_getdword(in) != pattern(seq, i);
+
+    return bad || ibytes_geterror(in) != CODEC_OK;
+}
+
+static void consume(int fd, unsigned short readlen, unsigned int flags, T_Run *run, int *uring)
+{
+    T_Ingest ig;
+    T_InputByteStream in[BATCH];
+    unsigned int ids[BATCH], n, i;
+
+    memset(run, 0, sizeof(*run));
+    if(ingest_init(&ig, fd, SLOTS, readlen, flags) != CODEC_OK)
+    {
+        run->bad = 1;
+        return;
+    }
+    *uring = ig.ring >= 0;
+
+    run->seconds = now();
+    while((n = ingest_next(&ig, in, ids, BATCH)) > 0)
+    {
+        for(i = 0; i < n; i++)
+        {
+            run->bad += check(&in[i], (unsigned int)run->records++);
+            run->bytes += in[i].bytes.totallen;
+            ingest_release(&ig, ids[i]);
+        }
+    }
+    run->seconds = now() - run->seconds;
+    run->bad += ingest_geterror(&ig) != CODEC_OK;
+
+    ingest_free(&ig);
+}
+
+/*taking every slot without releasing any runs the pool dry with an error, not an end of input*/
+static unsigned long holdall(int fd, unsigned int flags)
+{
+    T_Ingest ig;
+    T_InputByteStream in[BATCH];
+    unsigned int ids[SLOTS], held = 0, n, i;
+    unsigned long bad = 0;
+
+    if(ingest_init(&ig, fd, SLOTS, RECLEN, flags) != CODEC_OK)
+        return 1;
+
+    while(held < SLOTS && (n = ingest_next(&ig, in, &ids[held], SLOTS - held < BATCH ? SLOTS - held : BATCH)) > 0)
+        held += n;
+    bad += held != SLOTS;
+    bad += ingest_next(&ig, in, &i, 1) != 0 || ingest_geterror(&ig) != INGEST_ALLHELD;
+
+    for(i = 0; i < held; i++)
+        ingest_release(&ig, ids[i]);
+    bad += ingest_next(&ig, in, ids, BATCH) == 0 || ingest_geterror(&ig) != CODEC_OK;
+
+    ingest_free(&ig);
+    return bad;
+}
+
+static void report(const char *source, const char *mode, const T_Run *run)
+{
+    printf("%-8s %-10s %8lu records %8.0f MB/s %10.0f records/s %lu bad\n", source, mode, run->records,
+           run->bytes / run->seconds / 1e6, run->records / run->seconds, run->bad);
+}
+
+static unsigned long runfile(const char *path)
+{
+    static unsigned char rec[RECLEN];
+    T_Run run;
+    unsigned int i, mode;
+    unsigned long bad = 0;
+    int fd, uring = 0;
+
+    if((fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600)) < 0)
+    {
+        perror(path);
+        return 1;
+    }
+    for(i = 0; i < NUM_RECORDS; i++)
+    {
+        fill(rec, i, RECLEN);
+        if(write(fd, rec, RECLEN) != RECLEN)
+        {
+            perror(path);
+            close(fd);
+            return 1;
+        }
+    }
+    fdatasync(fd);
+
+    for(mode = 0; mode < 2; mode++)
+    {
+        posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        consume(fd, RECLEN, mode ? INGEST_BLOCKING : 0, &run, &uring);
+        bad += run.bad + (run.records != NUM_RECORDS);
+        report("file", mode ? "blocking" : uring ? "io_uring" : "fallback", &run);
+        bad += holdall(fd, mode ? INGEST_BLOCKING : 0);
+    }
+
+    close(fd);
+    return bad;
+}
+
+static void *writer(void *arg)
+{
+    unsigned char buf[RECLEN];
+    int fd = *(int *)arg;
+    unsigned int i;
+    unsigned short len;
+
+    for(i = 0; i < NUM_PACKETS; i++)
+    {
+        len = (unsigned short)(64 + (i * 37 % 16) * 64);
+        fill(buf, i, len);
+        if(send(fd, buf, len, 0) != len)
+            break;
+    }
+
+    shutdown(fd, SHUT_WR);
+    return NULL;
+}
+
+static unsigned long runsocket(void)
+{
+    pthread_t thread;
+    T_Run run;
+    unsigned int mode;
+    unsigned long bad = 0;
+    int sv[2], uring = 0;
+
+    for(mode = 0; mode < 2; mode++)
+    {
+        if(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0)
+        {
+            perror("socketpair");
+            return 1;
+        }
+        pthread_create(&thread, NULL, writer, &sv[1]);
+        consume(sv[0], RECLEN, mode ? INGEST_BLOCKING : 0, &run, &uring);
+        pthread_join(thread, NULL);
+        close(sv[0]);
+        close(sv[1]);
+
+        bad += run.bad + (run.records != NUM_PACKETS);
+        report("socket", mode ? "blocking" : uring ? "io_uring" : "fallback", &run);
+    }
+
+    return bad;
+}
+
+int main(int argc, char **argv)
+{
+    char path[] = "/tmp/ingest_benchXXXXXX";
+    unsigned long bad;
+    int fd;
+
+    (void)argc;
+    (void)argv;
+    if((fd = mkstemp(path)) < 0)
+    {
+        perror("mkstemp");
+        return 1;
+    }
+    close(fd);
+
+    bad = runfile(path);
+    unlink(path);
+    bad += runsocket();
+
+    printf("%lu bad\n", bad);
+    return bad != 0;
+}
@@ -0,0 +1,170 @@
+/*
+ * Decode rate of a duplicate-heavy message stream with and without the
+ * message cache. The stream repeats a small set of keep-alive and status
+ * messages with a share of unique ones; every cached result is checked
+ * against a direct decode, from two threads sharing the cache.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include "msgcache.h"
+
+#define NUM_MESSAGES  20000
+#define NUM_REPEATED  48
+#define UNIQUE_PCT    10
+#define MAX_MSGLEN    256
+#define MAX_FIELDS    (8 * MAX_MSGLEN / 3 + 1)
+#define ROUNDS        20
+#define NUM_THREADS   2
+
+typedef struct tagT_Decoded {
+    unsigned char type;
+    unsigned short nfields;
+    unsigned int fields[MAX_FIELDS];
+} T_Decoded;
+
+static unsigned char messages[NUM_MESSAGES][MAX_MSGLEN];
+static unsigned short lens[NUM_MESSAGES];
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*a type byte then 3, 5, 7, 3, 5, 7... bit fields*/
+static unsigned short decode(void *ctx, T_InputByteStream *msg, void *value)
+{
+    T_Decoded *d = value;
+    T_InputBitStream bits;
+    unsigned int left;
+    unsigned char w;
+
+    (void)ctx;
+    memset(d, 0, sizeof(*d));
+    d->type = ibytes_getbyte(msg);
+    left = 8 * (msg->bytes.totallen - 1);
+    ibytes_getbitstream(msg, msg->bytes.totallen - 1, &bits);
+    for(w = 3; left > 0; w = w == 7 ? 3 : w + 2)
+    {
+        if(w > left)
+            w = (unsigned char)left;
+        d->fields[d->nfields++] = ibits_getbit(&bits, w);
+        left -= w;
+    }
+
+    return ibytes_geterror(msg) != CODEC_OK ? ibytes_geterror(msg) : ibits_geterror(&bits);
+}
+
+static void makestream(void)
+{
+    static unsigned char repeated[NUM_REPEATED][MAX_MSGLEN];
+    static unsigned short replen[NUM_REPEATED];
+    unsigned int i, j;
+
+    srand(11);
+    for(i=0; i<NUM_REPEATED; i++)
+    {
+        replen[i] = 16 + rand() % (MAX_MSGLEN - 16);
+        for(j=0; j<replen[i]; j++)
+            repeated[i][j] = (unsigned char)rand();
+    }
+
+    for(i=0; i<NUM_MESSAGES; i++)
+    {
+        if(rand() % 100 < UNIQUE_PCT)
+        {
+            lens[i] = 16 + rand() % (MAX_MSGLEN - 16);
+            for(j=0; j<lens[i]; j++)
+                messages[i][j] = (unsigned char)rand();
+        }
+        else
+        {
+            j = rand() % NUM_REPEATED;
+            lens[i] = replen[j];
+            memcpy(messages[i], repeated[j], lens[i]);
+        }
+    }
+}
+
+static T_MsgCache cache;
+static unsigned long mismatches;
+
+static void *cachedworker(void *arg)
+{
+    T_Decoded *got = malloc(sizeof(T_Decoded)), *want = malloc(sizeof(T_Decoded));
+    T_InputByteStream in;
+    unsigned int i, start = *(unsigned int *)arg;
+
+    for(i=start; i<NUM_MESSAGES; i+=NUM_THREADS)
+    {
+        msgcache_decode(&cache, messages[i], lens[i], got);
+        ibytes_init(&in, messages[i], lens[i]);
+        decode(NULL, &in, want);
+        if(memcmp(got, want, sizeof(T_Decoded)) != 0)
+            __atomic_fetch_add(&mismatches, 1, __ATOMIC_RELAXED);
+    }
+
+    free(got);
+    free(want);
+    return NULL;
+}
+
+int main(void)
+{
+    static T_Decoded out;
+    T_InputByteStream in;
+    T_MsgCacheStats stats;
+    pthread_t threads[NUM_THREADS];
+    unsigned int ids[NUM_THREADS];
+    unsigned int i, r;
+    double tdirect, tcached;
+
+    makestream();
+    if(msgcache_init(&cache, 4, 64, MAX_MSGLEN, sizeof(T_Decoded), decode, NULL) != CODEC_OK)
+    {
+        printf("msgcache_init failed\n");
+        return 1;
+    }
+
+    for(i=0; i<NUM_THREADS; i++)
+    {
+        ids[i] = i;
+        pthread_create(&threads[i], NULL, cachedworker, &ids[i]);
+    }
+    for(i=0; i<NUM_THREADS; i++)
+        pthread_join(threads[i], NULL);
+
+    tdirect = now();
+    for(r=0; r<ROUNDS; r++)
+    {
+        for(i=0; i<NUM_MESSAGES; i++)
+        {
+            ibytes_init(&in, messages[i], lens[i]);
+            decode(NULL, &in, &out);
+        }
+    }
+    tdirect = now() - tdirect;
+
+    tcached = now();
+    for(r=0; r<ROUNDS; r++)
+    {
+        for(i=0; i<NUM_MESSAGES; i++)
+            msgcache_decode(&cache, messages[i], lens[i], &out);
+    }
+    tcached = now() - tcached;
+
+    msgcache_getstats(&cache, &stats);
+    printf("%u messages, %u%% unique, %lu cached results differ\n", NUM_MESSAGES, UNIQUE_PCT, mismatches);
+    printf("hits %llu misses %llu evictions %llu bypassed %llu, hit rate %.1f%%\n",
+           stats.hits, stats.misses, stats.evictions, stats.bypassed,
+           100.0 * stats.hits / (stats.hits + stats.misses + stats.bypassed));
+    printf("direct %.2f Mmsg/s, cached %.2f Mmsg/s\n",
+           ROUNDS * NUM_MESSAGES / tdirect / 1e6, ROUNDS * NUM_MESSAGES / tcached / 1e6);
+
+    msgcache_free(&cache);
+    return mismatches != 0;
+}
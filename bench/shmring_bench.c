@@ -0,0 +1,201 @@
+/*
+ * Message rate between two processes through a shared-memory ring, where
+ * the encoder writes into the slot the decoder reads, against the same
+ * messages copied through a socketpair. The consumer is a forked child
+ * that decodes and checks every message; its exit status is the number
+ * of bad ones.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include "shmring.h"
+
+#define NUM_MESSAGES  100000
+#define SLOTS         256
+
+static const unsigned short msglens[] = {64, 512, 2048};
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*sequence number, length, then words the consumer can recompute*/
+static void encode(T_OutputByteStream *out, unsigned int seq, unsigned short len)
+{
+    unsigned short i;
+
+    obytes_setdword(out, seq);
+    obytes_setword(out, len);
+    for(i=6; i+4<=len; i+=4)
+        obytes_setdword(out, seq * 2654435761u + i);
+}
+
+static int decode(T_InputByteStream *in, unsigned int seq, unsigned short len)
+{
+    unsigned short i;
+    int bad = 0;
+
+    bad |= ibytes_getdword(in) != seq;
+    bad |= ibytes_getword(in) != len;
+    for(i=6; i+4<=len; i+=4)
+        bad |= ibytes_getdword(in) != seq * 2654435761u + i;
+
+    return bad || ibytes_geterror(in) != CODEC_OK;
+}
+
+static int finish(pid_t pid)
+{
+    int status;
+
+    waitpid(pid, &status, 0);
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
+
+static int runshm(unsigned short len, double *rate)
+{
+    T_ShmRing ring;
+    T_OutputByteStream out;
+    T_InputByteStream in;
+    unsigned int seq, bad = 0;
+    double t;
+    pid_t pid;
+
+    if(shmring_create(&ring, SLOTS, len) != CODEC_OK)
+    {
+        perror("shmring_create");
+        return 1;
+    }
+
+    t = now();
+    if((pid = fork()) == 0)
+    {
+        for(seq=0; seq<NUM_MESSAGES; seq++)
+        {
+            shmring_acquire(&ring, &in, 1);
+            bad += decode(&in, seq, len);
+            shmring_release(&ring);
+        }
+        _exit(bad > 255 ? 255 : bad);
+    }
+
+    for(seq=0; seq<NUM_MESSAGES; seq++)
+    {
+        shmring_reserve(&ring, &out, 1);
+        encode(&out, seq, len);
+        shmring_publish(&ring, obytes_getlen(&out));
+    }
+
+    bad = finish(pid);
+    *rate = NUM_MESSAGES / (now() - t);
+    shmring_close(&ring);
+    return bad;
+}
+
+static int runsocket(unsigned short len, double *rate)
+{
+    static unsigned char buf[MAX_CODEC_BUFFER_LEN];
+    T_OutputByteStream out;
+    T_InputByteStream in;
+    unsigned int seq, bad = 0;
+    int sv[2];
+    ssize_t n;
+    double t;
+    pid_t pid;
+
+    if(socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sv) < 0)
+    {
+        perror("socketpair");
+        return 1;
+    }
+
+    t = now();
+    if((pid = fork()) == 0)
+    {
+        close(sv[0]);
+        for(seq=0; seq<NUM_MESSAGES; seq++)
+        {
+            n = recv(sv[1], buf, sizeof(buf), 0);
+            ibytes_init(&in, buf, n > 0 ? (unsigned short)n : 0);
+            bad += decode(&in, seq, len);
+        }
+        _exit(bad > 255 ? 255 : bad);
+    }
+
+    close(sv[1]);
+    for(seq=0; seq<NUM_MESSAGES; seq++)
+    {
+        obytes_init(&out, buf, len);
+        encode(&out, seq, len);
+        send(sv[0], obytes_getbuf(&out), obytes_getlen(&out), 0);
+    }
+
+    bad = finish(pid);
+    *rate = NUM_MESSAGES / (now() - t);
+    close(sv[0]);
+    return bad;
+}
+
+/*bit streams on the same ring, and the non-blocking edges*/
+static int checkbits(void)
+{
+    T_ShmRing ring, peer;
+    T_OutputBitStream out;
+    T_InputBitStream in;
+    T_OutputByteStream oy;
+    T_InputByteStream iy;
+    unsigned int i;
+    int bad = 0;
+
+    if(shmring_create(&ring, 4, 64) != CODEC_OK)
+        return 1;
+    if(shmring_open(&peer, dup(ring.fd)) != CODEC_OK)
+        return 1;
+
+    bad += shmring_acquire(&peer, &iy, 0) != SHMRING_EMPTY;
+    for(i=0; i<4; i++)
+    {
+        bad += shmring_reservebits(&ring, &out, 0) != CODEC_OK;
+        obits_setbit(&out, 13, i * 100 + 1);
+        obits_setbit(&out, 5, i);
+        shmring_publish(&ring, (obits_getlen(&out) + 7) / 8);
+    }
+    bad += shmring_reserve(&ring, &oy, 0) != SHMRING_FULL;
+
+    for(i=0; i<4; i++)
+    {
+        bad += shmring_acquirebits(&peer, &in, 0) != CODEC_OK;
+        bad += ibits_getbit(&in, 13) != i * 100 + 1 || ibits_getbit(&in, 5) != i;
+        shmring_release(&peer);
+    }
+    bad += shmring_acquire(&peer, &iy, 0) != SHMRING_EMPTY;
+    bad += shmring_reserve(&ring, &oy, 0) != CODEC_OK;
+
+    shmring_close(&peer);
+    shmring_close(&ring);
+    return bad;
+}
+
+int main(void)
+{
+    double shm = 0, sock = 0;
+    unsigned int i;
+    int bad = checkbits();
+
+    printf("%-8s %14s %14s\n", "msglen", "shmring/s", "socket/s");
+    for(i=0; i<sizeof(msglens)/sizeof(msglens[0]); i++)
+    {
+        bad += runshm(msglens[i], &shm);
+        bad += runsocket(msglens[i], &sock);
+        printf("%-8u %14.0f %14.0f\n", msglens[i], shm, sock);
+    }
+
+    printf("%d bad\n", bad);
+    return bad != 0;
+}
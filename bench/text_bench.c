@@ -0,0 +1,272 @@
+/*
+ * Hex and base64 conversion of encoded buffers: text_* against the
+ * byte-at-a-time sprintf/sscanf style conversion, on MAX_CODEC_BUFFER_LEN
+ * messages. Every length up to 100 bytes is checked against the reference
+ * in both directions, as are invalid characters at every position, bad
+ * lengths, results that do not fit and counting streams.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "text.h"
+
+#define MSGLEN   MAX_CODEC_BUFFER_LEN
+#define ROUNDS   2000
+
+static unsigned char msg[MSGLEN];
+static unsigned char text[TEXT_HEXLEN(MSGLEN) + 1];
+static unsigned char back[MSGLEN];
+static volatile unsigned int sink;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+/*the conversions text_* replaces*/
+static void refhex(const unsigned char *src, unsigned int n, char *dst)
+{
+    unsigned int i;
+
+    for(i = 0; i < n; i++)
+        sprintf(dst + 2 * i, "%02x", src[i]);
+}
+
+static int refunhex(const char *src, unsigned int n, unsigned char *dst)
+{
+    unsigned int i, v;
+
+    for(i = 0; i < n; i += 2)
+    {
+        if(sscanf(src + i, "%2x", &v) != 1)
+            return 0;
+        dst[i / 2] = (unsigned char)v;
+    }
+    return 1;
+}
+
+static const char b64digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static void refb64(const unsigned char *src, unsigned int n, char *dst)
+{
+    unsigned int i, v, k;
+
+    for(i = 0; i < n; i += 3, dst += 4)
+    {
+        for(k = 0, v = 0; k < 3; k++)
+            v = v << 8 | (i + k < n ? src[i + k] : 0);
+        for(k = 0; k < 4; k++)
+            dst[k] = k <= n - i ? b64digits[(v >> (18 - 6 * k)) & 0x3F] : '=';
+    }
+    *dst = 0;
+}
+
+/*'=' only as the last one or two characters*/
+static int refunb64(const char *src, unsigned int n, unsigned char *dst)
+{
+    unsigned int i, k, v, o = 0;
+    const char *p;
+
+    for(i = 0; i < n; i += 4)
+    {
+        for(k = 0, v = 0; k < 4; k++)
+        {
+            if(src[i + k] == '=')
+            {
+                if(i + 4 != n || k < 2 || (k == 2 && src[i + 3] != '='))
+                    return 0;
+                p = b64digits;
+            }
+            else if(src[i + k] == 0 || (p = strchr(b64digits, src[i + k])) == NULL)
+                return 0;
+            v = v << 6 | (unsigned int)(p - b64digits);
+        }
+        dst[o++] = (unsigned char)(v >> 16);
+        if(src[i + 2] != '=')
+            dst[o++] = (unsigned char)(v >> 8);
+        if(src[i + 3] != '=')
+            dst[o++] = (unsigned char)v;
+    }
+    return 1;
+}
+
+/*a failed decode must not write past the stream position either*/
+static int untouched(const unsigned char *p, unsigned int n)
+{
+    unsigned int i;
+
+    for(i = 0; i < n; i++)
+        if(p[i] != 0xA5)
+            return 0;
+    return 1;
+}
+
+static unsigned long check(void)
+{
+    static char ref[TEXT_HEXLEN(MSGLEN) + 1];
+    static unsigned char refout[MSGLEN];
+    static const char hexbad[] = "g G=/\xff\x80:@`", b64bad[] = " -_=.\xff\x80:@`";
+    T_OutputByteStream out, count;
+    unsigned long bad = 0;
+    unsigned int n, i, k, len, len2;
+    unsigned short r;
+    char keep;
+
+    for(n = 0; n <= 100; n++)
+    {
+        /*hex out and back, the reference decodes ours*/
+        refhex(msg, n, ref);
+        obytes_init(&out, text, sizeof(text));
+        bad += text_hexencode(msg, n, &out) != CODEC_OK || obytes_getlen(&out) != 2 * n || memcmp(text, ref, 2 * n);
+        obytes_init(&out, back, sizeof(back));
+        bad += text_hexdecode(ref, 2 * n, &out) != CODEC_OK || obytes_getlen(&out) != n || memcmp(back, msg, n);
+        for(i = 0; i < 2 * n; i++)
+            ref[i] = i % 3 ? ref[i] : (char)(ref[i] >= 'a' ? ref[i] - 32 : ref[i]);
+        obytes_init(&out, back, sizeof(back));
+        bad += text_hexdecode(ref, 2 * n, &out) != CODEC_OK || memcmp(back, msg, n);
+
+        /*base64 out and back*/
+        refb64(msg, n, ref);
+        len = TEXT_B64LEN(n);
+        obytes_init(&out, text, sizeof(text));
+        bad += text_b64encode(msg, n, &out) != CODEC_OK || obytes_getlen(&out) != len || memcmp(text, ref, len);
+        bad += !refunb64((char *)text, len, back) || memcmp(back, msg, n);
+        obytes_init(&out, back, sizeof(back));
+        bad += text_b64decode(ref, len, &out) != CODEC_OK || obytes_getlen(&out) != n || memcmp(back, msg, n);
+
+        /*
+         * One bad character anywhere fails the decode and leaves the stream and
+         * its buffer as they were. An '=' in the last four that makes valid
+         * padding must decode as the reference does instead.
+         */
+        for(i = 0; i < len; i++)
+        {
+            keep = ref[i];
+            for(k = 0; k < sizeof(b64bad) - 1; k++)
+            {
+                ref[i] = b64bad[k];
+                obytes_init(&out, back, sizeof(back));
+                obytes_init(&count, NULL, sizeof(back));
+                if(refunb64(ref, len, refout))
+                {
+                    len2 = len / 4 * 3 - (ref[len - 1] == '=') - (ref[len - 2] == '=');
+                    bad += text_b64decode(ref, len, &out) != CODEC_OK || obytes_getlen(&out) != len2 || memcmp(back, refout, len2);
+                    bad += text_b64decode(ref, len, &count) != CODEC_OK || obytes_getlen(&count) != len2;
+                    continue;
+                }
+                memset(back, 0xA5, sizeof(back));
+                bad += text_b64decode(ref, len, &out) != TEXT_BADCHAR || obytes_getlen(&out) != 0 || !untouched(back, sizeof(back));
+                bad += text_b64decode(ref, len, &count) != TEXT_BADCHAR;
+            }
+            ref[i] = keep;
+        }
+        refhex(msg, n, ref);
+        for(i = 0; i < 2 * n; i++)
+        {
+            keep = ref[i];
+            for(k = 0; k < sizeof(hexbad) - 1; k++)
+            {
+                ref[i] = hexbad[k];
+                obytes_init(&out, back, sizeof(back));
+                obytes_init(&count, NULL, sizeof(back));
+                memset(back, 0xA5, sizeof(back));
+                bad += text_hexdecode(ref, 2 * n, &out) != TEXT_BADCHAR || obytes_getlen(&out) != 0 || !untouched(back, sizeof(back));
+                bad += text_hexdecode(ref, 2 * n, &count) != TEXT_BADCHAR;
+            }
+            ref[i] = keep;
+        }
+    }
+
+    /*lengths, room, and counting streams that land where the real ones do*/
+    obytes_init(&out, back, sizeof(back));
+    bad += text_hexdecode("abc", 3, &out) != TEXT_BADLENGTH;
+    bad += text_b64decode("QUJD=", 5, &out) != TEXT_BADLENGTH;
+    bad += text_b64decode("QU=D", 4, &out) != TEXT_BADCHAR || refunb64("QU=D", 4, back);
+    obytes_init(&out, text, 10);
+    r = text_hexencode(msg, 6, &out);
+    bad += r != CODEC_SETTOOBITS || obytes_geterror(&out) != CODEC_SETTOOBITS || obytes_getlen(&out) != 0;
+    bad += text_b64encode(msg, 7, &out) != CODEC_SETTOOBITS;
+    obytes_init(&out, text, sizeof(text));
+    obytes_init(&count, NULL, sizeof(text));
+    text_b64encode(msg, MSGLEN, &out);
+    text_b64encode(msg, MSGLEN, &count);
+    bad += obytes_getlen(&count) != obytes_getlen(&out);
+    obytes_init(&count, NULL, MSGLEN);
+    bad += text_b64decode((char *)text, obytes_getlen(&out), &count) != CODEC_OK || obytes_getlen(&count) != MSGLEN;
+
+    return bad;
+}
+
+int main(void)
+{
+    static char ref[TEXT_HEXLEN(MSGLEN) + 1];
+    T_OutputByteStream out;
+    unsigned long bad;
+    unsigned int i, r;
+    double t[8];
+
+    srand(11);
+    for(i = 0; i < MSGLEN; i++)
+        msg[i] = (unsigned char)rand();
+
+    bad = check();
+
+    t[0] = now();
+    for(r = 0; r < ROUNDS / 20; r++)
+        refhex(msg, MSGLEN, ref);
+    t[0] = (now() - t[0]) * 20;
+    t[1] = now();
+    for(r = 0; r < ROUNDS / 20; r++)
+        sink += refunhex(ref, 2 * MSGLEN, back);
+    t[1] = (now() - t[1]) * 20;
+    t[2] = now();
+    for(r = 0; r < ROUNDS; r++)
+    {
+        obytes_init(&out, text, sizeof(text));
+        text_hexencode(msg, MSGLEN, &out);
+    }
+    t[2] = now() - t[2];
+    t[3] = now();
+    for(r = 0; r < ROUNDS; r++)
+    {
+        obytes_init(&out, back, sizeof(back));
+        bad += text_hexdecode((char *)text, 2 * MSGLEN, &out) != CODEC_OK;
+    }
+    t[3] = now() - t[3];
+    bad += memcmp(back, msg, MSGLEN) != 0;
+
+    t[4] = now();
+    for(r = 0; r < ROUNDS / 20; r++)
+        refb64(msg, MSGLEN, ref);
+    t[4] = (now() - t[4]) * 20;
+    t[5] = now();
+    for(r = 0; r < ROUNDS / 20; r++)
+        sink += refunb64(ref, TEXT_B64LEN(MSGLEN), back);
+    t[5] = (now() - t[5]) * 20;
+    t[6] = now();
+    for(r = 0; r < ROUNDS; r++)
+    {
+        obytes_init(&out, text, sizeof(text));
+        text_b64encode(msg, MSGLEN, &out);
+    }
+    t[6] = now() - t[6];
+    t[7] = now();
+    for(r = 0; r < ROUNDS; r++)
+    {
+        obytes_init(&out, back, sizeof(back));
+        bad += text_b64decode((char *)text, TEXT_B64LEN(MSGLEN), &out) != CODEC_OK;
+    }
+    t[7] = now() - t[7];
+    bad += memcmp(back, msg, MSGLEN) != 0;
+
+    printf("%-7s %-7s %10s %10s\n", "", "", "reference", "text_*");
+    for(i = 0; i < 4; i++)
+        printf("%-7s %-7s %7.0f MB/s %7.0f MB/s\n", i < 2 ? "hex" : "base64", i % 2 ? "decode" : "encode",
+               1e-6 * ROUNDS * MSGLEN / t[i % 2 + 4 * (i / 2)], 1e-6 * ROUNDS * MSGLEN / t[i % 2 + 4 * (i / 2) + 2]);
+
+    printf("%lu bad\n", bad);
+    return bad != 0;
+}
@@ -0,0 +1,55 @@
+#ifndef BITPACK_H
+#define BITPACK_H
+
+#include "codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*column modes*/
+#define BITPACK_FOR    0      /*each block stores its minimum, values are packed as value - minimum*/
+#define BITPACK_DELTA  1      /*for sorted or slowly moving series, differences from the previous value*/
+
+/*results besides CODEC_OK and the stream errors*/
+#define BITPACK_TOOMANY  16   /*more than BITPACK_MAXVALUES to encode, or than max to decode*/
+#define BITPACK_CORRUPT  17   /*unknown mode, width or exception out of range*/
+
+#define BITPACK_BLOCK      128
+#define BITPACK_MAXVALUES  0xFFFF
+
+/*
+ * A column is a 2-bit mode and a 16-bit count, in DELTA mode followed by
+ * the first value, then blocks of BITPACK_BLOCK values. A block holds a
+ * 6-bit width b, an 8-bit exception count, the exception width when there
+ * are exceptions, a 32-bit base, the low b bits of every value, then each
+ * exception as a 7-bit position and the bits above b. The width is chosen
+ * per block to minimise its size, so a few outliers become exceptions
+ * instead of widening every value.
+ *
+ * The low bits start on a byte boundary and do not depend on the bit
+ * order of the stream. In a full block they are four interleaved lanes of
+ * little-endian 32-bit words, value i in lane i % 4, so they are packed
+ * and unpacked four at a time with SSE2; a final short block packs them
+ * as one little-endian bit string. Every other field follows the bit
+ * order of the stream.
+ *
+ * Decoding does not reach several billion values a second. The unpack
+ * kernels run at 9-13 G/s on their own, but each block also reads its
+ * header through the bit stream accessors, DELTA blocks pay for a prefix
+ * sum of three shuffles per four values, and the final short block is
+ * unpacked one value at a time. Full blocks in cache decode at about 1.2
+ * G/s for DELTA timestamps, 1.7 G/s for FOR counters and 2.9 G/s for
+ * random words; wider kernels would not help while the kernel is not the
+ * cost.
+ */
+unsigned short bitpack_encode(T_OutputBitStream *out, const unsigned int *values, unsigned int n, unsigned int mode);
+
+/*decodes one column into values, *n is set to its count*/
+unsigned short bitpack_decode(T_InputBitStream *in, unsigned int *values, unsigned int max, unsigned int *n);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef CABAC_H
+#define CABAC_H
+
+#include "codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Context-adaptive binary arithmetic coder using the H.264 CABAC
+ * probability states and range tables. A context is (state << 1) | mps,
+ * zero-initialised contexts start equiprobable.
+ */
+typedef unsigned char T_CabacContext;
+
+typedef struct tagT_CabacEncoder {
+    T_OutputBitStream *bits;
+    unsigned int low;
+    unsigned int range;
+    int queue;                 /*bits of low waiting to form a byte*/
+    int cache;                 /*last byte not yet written, -1 if none*/
+    unsigned int outstanding;  /*0xff bytes after cache, may still carry*/
+} T_CabacEncoder;
+
+typedef struct tagT_CabacDecoder {
+    T_InputBitStream *bits;
+    unsigned int value;        /*9-bit offset followed by count buffered bits*/
+    unsigned int range;
+    int count;
+} T_CabacDecoder;
+
+void cabac_encodeinit(T_CabacEncoder *enc, T_OutputBitStream *bits);
+void cabac_encodebin(T_CabacEncoder *enc, T_CabacContext *ctx, unsigned char bin);
+void cabac_encodebypass(T_CabacEncoder *enc, unsigned char bin);
+void cabac_encodeterminate(T_CabacEncoder *enc, unsigned char bin);
+void cabac_encodeflush(T_CabacEncoder *enc);
+
+void cabac_decodeinit(T_CabacDecoder *dec, T_InputBitStream *bits);
+unsigned char cabac_decodebin(T_CabacDecoder *dec, T_CabacContext *ctx);
+unsigned char cabac_decodebypass(T_CabacDecoder *dec);
+unsigned char cabac_decodeterminate(T_CabacDecoder *dec);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
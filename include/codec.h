@@ -5,6 +5,27 @@
 extern "C" {
 #endif
 
+/*
+ * Define CODEC_HEADER_ONLY before including this header to get the whole
+ * stream API as static inline functions, so calls with constant widths are
+ * specialized at the call site. Without it the functions come from codec.c.
+ */
+#if defined(__cplusplus)
+#define CODEC_INLINE inline
+#elif defined(_MSC_VER)
+#define CODEC_INLINE __inline
+#elif defined(__GNUC__)
+#define CODEC_INLINE __inline__
+#else
+#define CODEC_INLINE inline
+#endif
+
+#ifdef CODEC_HEADER_ONLY
+#define CODEC_API static CODEC_INLINE
+#else
+#define CODEC_API
+#endif
+
 #define MAX_CODEC_BUFFER_LEN  4096
 
 #define CODEC_ENCODE            0
@@ -17,15 +38,61 @@ extern "C" {
 #define CODEC_GETZEROBITS 4
 #define CODEC_SETZEROBITS 5
 
+#define CODEC_NOPOS  0xFFFF   /*position returned when a search fails*/
+
+/*bit order of bit streams*/
+#define CODEC_MSB_FIRST   0
+#define CODEC_LSB_FIRST   1
+
+/*word order of byte streams*/
+#define CODEC_BIG_ENDIAN     0
+#define CODEC_LITTLE_ENDIAN  1
+
+/*order given to streams by init, may be overridden when building codec.c*/
+#ifndef CODEC_BITORDER
+#define CODEC_BITORDER   CODEC_MSB_FIRST
+#endif
+
+#ifndef CODEC_BYTEORDER
+#define CODEC_BYTEORDER  CODEC_BIG_ENDIAN
+#endif
+
+/*stream primitives as counted and traced by the optional CODEC_STATS and CODEC_TRACE hooks*/
+enum {
+    CODEC_OP_IBYTES_GETBYTE, CODEC_OP_IBYTES_GETWORD, CODEC_OP_IBYTES_GETDWORD,
+    CODEC_OP_IBYTES_FORWARD, CODEC_OP_IBYTES_BACK,
+    CODEC_OP_OBYTES_SETBYTE, CODEC_OP_OBYTES_SETWORD, CODEC_OP_OBYTES_SETDWORD,
+    CODEC_OP_OBYTES_SETBYTESLICE, CODEC_OP_OBYTES_SETBYTEBYPOS,
+    CODEC_OP_OBYTES_SETWORDBYPOS, CODEC_OP_OBYTES_SETDWORDBYPOS,
+    CODEC_OP_IBITS_GETBIT, CODEC_OP_IBITS_FORWARD, CODEC_OP_IBITS_FINDPATTERN,
+    CODEC_OP_OBITS_SETBIT, CODEC_OP_OBITS_SETBITBYPOS,
+    CODEC_OP_IBITS_BACK, CODEC_OP_IBITS_PEEK,
+    CODEC_OPS
+};
+
+/*inline in every build so the stats and trace modules need no codec.o*/
+static CODEC_INLINE const char *codec_opname(unsigned int op)
+{
+    static const char *names[CODEC_OPS] = {
+        "ibytes_getbyte", "ibytes_getword", "ibytes_getdword", "ibytes_forward", "ibytes_back",
+        "obytes_setbyte", "obytes_setword", "obytes_setdword", "obytes_setbyteslice",
+        "obytes_setbytebypos", "obytes_setwordbypos", "obytes_setdwordbypos",
+        "ibits_getbit", "ibits_forward", "ibits_findpattern", "obits_setbit", "obits_setbitbypos",
+        "ibits_back", "ibits_peek"
+        };
+
+    return op < CODEC_OPS ? names[op] : "unknown";
+}
+
 /*common function*/
-unsigned char getbyteslice(unsigned char byte, unsigned char begin, unsigned char end);
-unsigned char getbytehi(unsigned char byte, unsigned char n);
-unsigned char getbytelow(unsigned char byte, unsigned char n);
-void setbyteslice(unsigned char *byte, unsigned char begin, unsigned char end, unsigned char value);
-void setbytehi(unsigned char *byte, unsigned char n, unsigned char value);
-void setbytelow(unsigned char *byte, unsigned char n, unsigned char value);
-unsigned short getshortslice(unsigned short value, unsigned char begin, unsigned char end);
-unsigned int getintslice(unsigned int value, unsigned char begin, unsigned char end);
+CODEC_API unsigned char getbyteslice(unsigned char byte, unsigned char begin, unsigned char end);
+CODEC_API unsigned char getbytehi(unsigned char byte, unsigned char n);
+CODEC_API unsigned char getbytelow(unsigned char byte, unsigned char n);
+CODEC_API void setbyteslice(unsigned char *byte, unsigned char begin, unsigned char end, unsigned char value);
+CODEC_API void setbytehi(unsigned char *byte, unsigned char n, unsigned char value);
+CODEC_API void setbytelow(unsigned char *byte, unsigned char n, unsigned char value);
+CODEC_API unsigned short getshortslice(unsigned short value, unsigned char begin, unsigned char end);
+CODEC_API unsigned int getintslice(unsigned int value, unsigned char begin, unsigned char end);
 
 /*byte stream*/
 typedef struct tagT_ByteStream {
@@ -33,7 +100,10 @@ typedef struct tagT_ByteStream {
     unsigned short totallen;
     unsigned short curbyte;  /*current byte index*/
     unsigned short error;
-    unsigned short reserved;
+    unsigned short order;    /*CODEC_BIG_ENDIAN or CODEC_LITTLE_ENDIAN*/
+#ifdef CODEC_STATS
+    struct tagT_CodecStats *stats;  /*counters of the thread that initialized the stream*/
+#endif
 } T_ByteStream;
 
 typedef struct tagT_InputByteStream {
@@ -50,7 +120,11 @@ typedef struct tagT_BitStream {
     unsigned short totallen;
     unsigned short curbyte; /*current byte index*/
     unsigned short curbit;  /*current bit index*/
-    unsigned short error;
+    unsigned char  error;   /*error and order share the 16 bits error had, keeping the struct at 16 bytes*/
+    unsigned char  order;   /*CODEC_MSB_FIRST or CODEC_LSB_FIRST*/
+#ifdef CODEC_STATS
+    struct tagT_CodecStats *stats;  /*counters of the thread that initialized the stream*/
+#endif
 } T_BitStream;
 
 typedef struct tagT_InputBitStream {
@@ -61,58 +135,86 @@ typedef struct tagT_OutputBitStream {
     T_BitStream bits;
 } T_OutputBitStream;
 
+/*read state saved by ibits_save, the buffer and length never change*/
+typedef struct tagT_BitMark {
+    unsigned short curbyte;
+    unsigned short curbit;
+    unsigned short error;
+    unsigned short order;
+} T_BitMark;
+
 /*input byte stream function*/
-void ibytes_init(T_InputByteStream *buf, unsigned char *msg, unsigned short totallen);
-void ibytes_forward(T_InputByteStream *buf, unsigned short n);
-void ibytes_back(T_InputByteStream *buf, unsigned short n);
-unsigned short ibytes_geterror(T_InputByteStream *buf);
-unsigned short ibytes_getlen(T_InputByteStream *buf);
-unsigned short ibytes_getcurpos(T_InputByteStream *buf);
-unsigned char ibytes_getbyte(T_InputByteStream *buf);
-unsigned short ibytes_getword(T_InputByteStream *buf);
-unsigned int ibytes_getdword(T_InputByteStream *buf);
-void ibytes_getbitstream(T_InputByteStream *bytes, unsigned short n, T_InputBitStream *bits);
+CODEC_API void ibytes_init(T_InputByteStream *buf, unsigned char *msg, unsigned short totallen);
+CODEC_API void ibytes_setorder(T_InputByteStream *buf, unsigned short order);
+CODEC_API void ibytes_forward(T_InputByteStream *buf, unsigned short n);
+CODEC_API void ibytes_back(T_InputByteStream *buf, unsigned short n);
+CODEC_API unsigned short ibytes_geterror(T_InputByteStream *buf);
+CODEC_API unsigned short ibytes_getlen(T_InputByteStream *buf);
+CODEC_API unsigned short ibytes_getcurpos(T_InputByteStream *buf);
+CODEC_API unsigned char ibytes_getbyte(T_InputByteStream *buf);
+CODEC_API unsigned short ibytes_getword(T_InputByteStream *buf);
+CODEC_API unsigned int ibytes_getdword(T_InputByteStream *buf);
+CODEC_API void ibytes_getbitstream(T_InputByteStream *bytes, unsigned short n, T_InputBitStream *bits);
+
+/*
+ * Output streams initialised with a NULL msg only count: every call checks
+ * totallen and moves the position as usual but writes nothing, so running
+ * an encoder once over a counting stream gives obytes_getlen/obits_getlen
+ * and the error it would end with, for sizing a buffer or a length prefix.
+ * getbuf returns NULL.
+ */
 
 /*output byte stream function*/
-void obytes_init(T_OutputByteStream *buf, unsigned char *msg, unsigned short totallen);
-unsigned short obytes_geterror(T_OutputByteStream *buf);
-unsigned short obytes_getlen(T_OutputByteStream *buf);
-unsigned short obytes_getcurpos(T_OutputByteStream *buf);
-void obytes_setbyte(T_OutputByteStream *buf, unsigned char value);
-void obytes_setword(T_OutputByteStream *buf, unsigned short value);
-void obytes_setdword(T_OutputByteStream *buf, unsigned int value);
-void obytes_setbyteslice(T_OutputByteStream *buf, unsigned char begin, unsigned char end, unsigned char value);
-void obytes_setbytebypos(T_OutputByteStream *buf, unsigned short pos, unsigned char value);
-void obytes_setwordbypos(T_OutputByteStream *buf, unsigned short pos, unsigned short value);
-void obytes_setdwordbypos(T_OutputByteStream *buf, unsigned short pos, unsigned int value);
-unsigned char * obytes_getbuf(T_OutputByteStream *buf);
+CODEC_API void obytes_init(T_OutputByteStream *buf, unsigned char *msg, unsigned short totallen);
+CODEC_API void obytes_setorder(T_OutputByteStream *buf, unsigned short order);
+CODEC_API unsigned short obytes_geterror(T_OutputByteStream *buf);
+CODEC_API unsigned short obytes_getlen(T_OutputByteStream *buf);
+CODEC_API unsigned short obytes_getcurpos(T_OutputByteStream *buf);
+CODEC_API void obytes_setbyte(T_OutputByteStream *buf, unsigned char value);
+CODEC_API void obytes_setword(T_OutputByteStream *buf, unsigned short value);
+CODEC_API void obytes_setdword(T_OutputByteStream *buf, unsigned int value);
+CODEC_API void obytes_setbyteslice(T_OutputByteStream *buf, unsigned char begin, unsigned char end, unsigned char value);
+CODEC_API void obytes_setbytebypos(T_OutputByteStream *buf, unsigned short pos, unsigned char value);
+CODEC_API void obytes_setwordbypos(T_OutputByteStream *buf, unsigned short pos, unsigned short value);
+CODEC_API void obytes_setdwordbypos(T_OutputByteStream *buf, unsigned short pos, unsigned int value);
+CODEC_API unsigned char * obytes_getbuf(T_OutputByteStream *buf);
 
 /*input bit stream function*/
-void ibits_init(T_InputBitStream *buf, unsigned char *msg, unsigned short totallen);
-void ibits_forward(T_InputBitStream *buf, unsigned short n);
-unsigned short ibits_geterror(T_InputBitStream *buf);
-unsigned short ibits_getlen(T_InputBitStream *buf);
-unsigned short ibits_getcurpos(T_InputBitStream *buf);
-unsigned int ibits_getbit(T_InputBitStream *buf, unsigned char n);
-unsigned char ibits_getbyte(T_InputBitStream *buf);
-unsigned short ibits_getword(T_InputBitStream *buf);
-unsigned int ibits_getdword(T_InputBitStream *buf);
+CODEC_API void ibits_init(T_InputBitStream *buf, unsigned char *msg, unsigned short totallen);
+CODEC_API void ibits_setorder(T_InputBitStream *buf, unsigned short order);
+CODEC_API void ibits_forward(T_InputBitStream *buf, unsigned short n);
+CODEC_API void ibits_back(T_InputBitStream *buf, unsigned short n);
+CODEC_API void ibits_save(T_InputBitStream *buf, T_BitMark *mark);
+CODEC_API void ibits_restore(T_InputBitStream *buf, const T_BitMark *mark);
+CODEC_API unsigned short ibits_geterror(T_InputBitStream *buf);
+CODEC_API unsigned short ibits_getlen(T_InputBitStream *buf);
+CODEC_API unsigned short ibits_getcurpos(T_InputBitStream *buf);
+CODEC_API unsigned int ibits_getbit(T_InputBitStream *buf, unsigned char n);
+CODEC_API unsigned int ibits_peek(T_InputBitStream *buf, unsigned char n);
+CODEC_API unsigned char ibits_getbyte(T_InputBitStream *buf);
+CODEC_API unsigned short ibits_getword(T_InputBitStream *buf);
+CODEC_API unsigned int ibits_getdword(T_InputBitStream *buf);
+CODEC_API unsigned short ibits_findpattern(T_InputBitStream *buf, unsigned long long pattern, unsigned char width, unsigned char maxerrors);
 
 /*output bit stream function*/
-void obits_init(T_OutputBitStream *buf, unsigned char *msg, unsigned short totallen);
-unsigned short obits_geterror(T_OutputBitStream *buf);
-unsigned short obits_getlen(T_OutputBitStream *buf);
-unsigned short obits_getcurpos(T_OutputBitStream *buf);
-void obits_setbit(T_OutputBitStream *buf, unsigned char len, unsigned int value);
-void obits_setbyte(T_OutputBitStream *buf, unsigned char value);
-void obits_setword(T_OutputBitStream *buf, unsigned short value);
-void obits_setdword(T_OutputBitStream *buf, unsigned int value);
-void obits_setbitbypos(T_OutputBitStream *buf, unsigned short pos, unsigned char len, unsigned int value);
-void obits_setbytebypos(T_OutputBitStream *buf, unsigned short pos, unsigned char value);
-void obits_setwordbypos(T_OutputBitStream *buf, unsigned short pos, unsigned short value);
-void obits_setdwordbypos(T_OutputBitStream *buf, unsigned short pos, unsigned int value);
-unsigned char * obits_getbuf(T_OutputBitStream *buf);
-
+CODEC_API void obits_init(T_OutputBitStream *buf, unsigned char *msg, unsigned short totallen);
+CODEC_API void obits_setorder(T_OutputBitStream *buf, unsigned short order);
+CODEC_API unsigned short obits_geterror(T_OutputBitStream *buf);
+CODEC_API unsigned short obits_getlen(T_OutputBitStream *buf);
+CODEC_API unsigned short obits_getcurpos(T_OutputBitStream *buf);
+CODEC_API void obits_setbit(T_OutputBitStream *buf, unsigned char len, unsigned int value);
+CODEC_API void obits_setbyte(T_OutputBitStream *buf, unsigned char value);
+CODEC_API void obits_setword(T_OutputBitStream *buf, unsigned short value);
+CODEC_API void obits_setdword(T_OutputBitStream *buf, unsigned int value);
+CODEC_API void obits_setbitbypos(T_OutputBitStream *buf, unsigned short pos, unsigned char len, unsigned int value);
+CODEC_API void obits_setbytebypos(T_OutputBitStream *buf, unsigned short pos, unsigned char value);
+CODEC_API void obits_setwordbypos(T_OutputBitStream *buf, unsigned short pos, unsigned short value);
+CODEC_API void obits_setdwordbypos(T_OutputBitStream *buf, unsigned short pos, unsigned int value);
+CODEC_API unsigned char * obits_getbuf(T_OutputBitStream *buf);
+
+#ifdef CODEC_HEADER_ONLY
+#include "codec_impl.h"
+#endif
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,1427 @@
+#ifndef CODEC_IMPL_H
+#define CODEC_IMPL_H
+
+/*
+ * Stream implementation shared by codec.c and the header-only build.
+ * Do not include directly: include codec.h, defining CODEC_HEADER_ONLY
+ * to get every function as a static inline definition in the caller.
+ */
+
+#include <string.h>
+
+#ifdef CODEC_HEADER_ONLY
+#define CODEC_LOCAL static CODEC_INLINE
+#else
+#define CODEC_LOCAL static
+#endif
+
+/*static but never inlined, in the header-only build too*/
+#if defined(__GNUC__)
+#define CODEC_OUTOFLINE static __attribute__((noinline, unused))
+#else
+#define CODEC_OUTOFLINE static
+#endif
+
+/*the loop that follows is unrolled 8 times, where the compiler takes a hint*/
+#if defined(__GNUC__)
+#define CODEC_UNROLL8 _Pragma("GCC unroll 8")
+#else
+#define CODEC_UNROLL8
+#endif
+
+#ifdef CODEC_STATS
+#include "codec_stats.h"
+#define CODEC_STATS_COUNT(stream, prim)         codec_stats_count((stream)->stats, CODEC_OP_##prim)
+#define CODEC_STATS_MOVE(stream, prim, bits)    codec_stats_move((stream)->stats, CODEC_OP_##prim, bits)
+#define CODEC_STATS_ERROR(stream, code)         codec_stats_error((stream)->stats, code)
+#define CODEC_STATS_ENTER(stream)               ((stream)->stats = codec_stats_enter())
+#else
+#define CODEC_STATS_COUNT(stream, prim)
+#define CODEC_STATS_MOVE(stream, prim, bits)
+#define CODEC_STATS_ERROR(stream, code)
+#define CODEC_STATS_ENTER(stream)
+#endif
+
+#ifdef CODEC_TRACE
+#include "codec_trace.h"
+#define CODEC_TRACE_PUT(op, stream, pos, width, value)  codec_trace_event(CODEC_OP_##op, stream, pos, width, value)
+#define CODEC_TRACE_GET(op, stream, pos, width, type, call) \
+    { unsigned short tpos = (pos); type tvalue = call; codec_trace_event(CODEC_OP_##op, stream, tpos, width, tvalue); return tvalue; }
+#define CODEC_TRACE_ENTER()                             codec_trace_enter()
+#else
+#define CODEC_TRACE_PUT(op, stream, pos, width, value)
+#define CODEC_TRACE_GET(op, stream, pos, width, type, call)  return call;
+#define CODEC_TRACE_ENTER()
+#endif
+
+static const unsigned int highmask[] = {
+    1, 3, 7, 0xf, 0x1f, 0x3f, 0x7f, 0xff,
+    0x1ff, 0x3ff, 0x7ff, 0xfff, 0x1fff, 0x3fff, 0x7fff, 0xffff,
+    0x1ffff, 0x3ffff, 0x7ffff, 0xfffff, 0x1fffff, 0x3fffff, 0x7fffff, 0xffffff,
+    0x1ffffff, 0x3ffffff, 0x7ffffff, 0xfffffff, 0x1fffffff, 0x3fffffff, 0x7fffffff, 0xffffffff
+    };
+
+/*byte stream function*/
+CODEC_LOCAL void bytes_init(T_ByteStream *buf, unsigned char *msg, unsigned short totallen, unsigned char mode);
+CODEC_LOCAL void bytes_setorder(T_ByteStream *buf, unsigned short order);
+CODEC_LOCAL void bytes_forward(T_ByteStream *buf, unsigned short n);
+CODEC_LOCAL void bytes_back(T_ByteStream *buf, unsigned short n);
+CODEC_LOCAL unsigned short bytes_geterror(T_ByteStream *buf);
+CODEC_LOCAL unsigned short bytes_getlen(T_ByteStream *buf);
+CODEC_LOCAL unsigned short bytes_getcurpos(T_ByteStream *buf);
+CODEC_LOCAL unsigned char * bytes_getbuf(T_ByteStream *buf);
+
+/*decode function*/
+CODEC_LOCAL unsigned char bytes_getbyte(T_ByteStream *buf);
+CODEC_LOCAL unsigned short bytes_getword(T_ByteStream *buf);
+CODEC_LOCAL unsigned int bytes_getdword(T_ByteStream *buf);
+CODEC_LOCAL void bytes_getbitstream(T_ByteStream *bytes, unsigned short n, T_BitStream *bits);
+
+/*encode function*/
+CODEC_LOCAL void bytes_setbyte(T_ByteStream *buf, unsigned char value);
+CODEC_LOCAL void bytes_setword(T_ByteStream *buf, unsigned short value);
+CODEC_LOCAL void bytes_setdword(T_ByteStream *buf, unsigned int value);
+CODEC_LOCAL void bytes_setbyteslice(T_ByteStream *buf, unsigned char begin, unsigned char end, unsigned char value);
+
+CODEC_LOCAL void bytes_setbytebypos(T_ByteStream *buf, unsigned short pos, unsigned char value);
+CODEC_LOCAL void bytes_setwordbypos(T_ByteStream *buf, unsigned short pos, unsigned short value);
+CODEC_LOCAL void bytes_setdwordbypos(T_ByteStream *buf, unsigned short pos, unsigned int value);
+
+
+/*bit stream function*/
+CODEC_LOCAL void bits_init(T_BitStream *buf, unsigned char *msg, unsigned short totallen, unsigned char mode);
+CODEC_LOCAL void bits_setorder(T_BitStream *buf, unsigned short order);
+CODEC_LOCAL void bits_forward(T_BitStream *buf, unsigned short n);
+CODEC_LOCAL void bits_back(T_BitStream *buf, unsigned short n);
+CODEC_LOCAL unsigned short bits_geterror(T_BitStream *buf);
+CODEC_LOCAL unsigned short bits_getlen(T_BitStream *buf);
+CODEC_LOCAL unsigned short bits_getcurpos(T_BitStream *buf);
+CODEC_LOCAL unsigned char * bits_getbuf(T_BitStream *buf);
+
+/*decode function*/
+CODEC_LOCAL unsigned int bits_getbit(T_BitStream *buf, unsigned char n);
+CODEC_LOCAL unsigned int bits_peek(T_BitStream *buf, unsigned char n);
+CODEC_LOCAL unsigned int bits_getmsb(const unsigned char *msg, unsigned short pos, unsigned char n);
+CODEC_LOCAL unsigned int bits_getlsb(const unsigned char *msg, unsigned short pos, unsigned char n);
+CODEC_LOCAL unsigned int bits_getnative(const unsigned char *msg, unsigned short pos, unsigned char n);
+CODEC_OUTOFLINE unsigned int bits_getother(const unsigned char *msg, unsigned short pos, unsigned char n);
+CODEC_LOCAL unsigned char bits_getbyte(T_BitStream *buf);
+CODEC_LOCAL unsigned short bits_getword(T_BitStream *buf);
+CODEC_LOCAL unsigned int bits_getdword(T_BitStream *buf);
+CODEC_LOCAL unsigned char bits_popcount(unsigned long long x);
+CODEC_LOCAL unsigned long long bits_loadmsb(const unsigned char *p);
+CODEC_LOCAL unsigned long long bits_loadlsb(const unsigned char *p);
+CODEC_LOCAL unsigned int bits_findmsb(T_BitStream *buf, unsigned long long pattern, unsigned char width, unsigned char maxerrors);
+CODEC_LOCAL unsigned int bits_findlsb(T_BitStream *buf, unsigned long long pattern, unsigned char width, unsigned char maxerrors);
+CODEC_LOCAL unsigned short bits_findpattern(T_BitStream *buf, unsigned long long pattern, unsigned char width, unsigned char maxerrors);
+
+/*encode function*/
+CODEC_LOCAL void bits_setbit(T_BitStream *buf, unsigned char len, unsigned int value);
+CODEC_LOCAL void bits_setmsb(unsigned char *msg, unsigned short pos, unsigned char len, unsigned int value);
+CODEC_LOCAL void bits_setlsb(unsigned char *msg, unsigned short pos, unsigned char len, unsigned int value);
+CODEC_LOCAL void bits_setnative(unsigned char *msg, unsigned short pos, unsigned char len, unsigned int value);
+CODEC_OUTOFLINE void bits_setother(unsigned char *msg, unsigned short pos, unsigned char len, unsigned int value);
+CODEC_LOCAL void bits_setbyte(T_BitStream *buf, unsigned char value);
+CODEC_LOCAL void bits_setword(T_BitStream *buf, unsigned short value);
+CODEC_LOCAL void bits_setdword(T_BitStream *buf, unsigned int value);
+
+CODEC_LOCAL void bits_setbitbypos(T_BitStream *buf, unsigned short pos, unsigned char len, unsigned int value);
+CODEC_LOCAL void bits_setbytebypos(T_BitStream *buf, unsigned short pos, unsigned char value);
+CODEC_LOCAL void bits_setwordbypos(T_BitStream *buf, unsigned short pos, unsigned short value);
+CODEC_LOCAL void bits_setdwordbypos(T_BitStream *buf, unsigned short pos, unsigned int value);
+
+
+/*helper function*/
+unsigned char getbyteslice(unsigned char byte, unsigned char begin, unsigned char end)
+{
+    unsigned char temp = 0;
+
+    if(begin < end)
+    {
+        temp = begin;
+        begin = end;
+        end = temp;
+    }
+
+    if(begin > 7)
+    {
+        begin = 7;
+    }
+
+    return (byte & (unsigned char)(highmask[begin])) >> end;
+}
+
+unsigned char getbytehi(unsigned char byte, unsigned char n)
+{
+    return getbyteslice(byte, 7, 8 - n);
+}
+
+unsigned char getbytelow(unsigned char byte, unsigned char n)
+{
+    return getbyteslice(byte, n - 1, 0);
+}
+
+void setbyteslice(unsigned char *byte, unsigned char begin, unsigned char end, unsigned char value)
+{
+    unsigned char temp = 0;
+    unsigned char temp_hi, temp_low;
+
+    if(begin < end)
+    {
+        temp = begin;
+        begin = end;
+        end = temp;
+    }
+
+    if(begin > 7)
+    {
+        begin = 7;
+    }
+
+    temp_hi = getbytehi(*byte, 7 - begin);
+    temp_low = getbytelow(*byte, end);
+
+    *byte = (temp_hi << (begin + 1)) | (value << end) | (temp_low);
+
+}
+
+void setbytehi(unsigned char *byte, unsigned char n, unsigned char value)
+{
+    setbyteslice(byte, 7, 8 - n, value);
+}
+
+void setbytelow(unsigned char *byte, unsigned char n, unsigned char value)
+{
+    setbyteslice(byte, n - 1, 0, value);
+}
+
+unsigned short getshortslice(unsigned short value, unsigned char begin, unsigned char end)
+{
+    unsigned char temp = 0;
+
+    if(begin < end)
+    {
+        temp = begin;
+        begin = end;
+        end = temp;
+    }
+
+    return (value & (unsigned short)(highmask[begin])) >> end;
+
+}
+
+unsigned int getintslice(unsigned int value, unsigned char begin, unsigned char end)
+{
+    unsigned char temp = 0;
+
+    if(begin < end)
+    {
+        temp = begin;
+        begin = end;
+        end = temp;
+    }
+
+    return (value & highmask[begin]) >> end;
+
+}
+
+void bytes_init(T_ByteStream *buf, unsigned char *msg, unsigned short totallen, unsigned char mode)
+{
+    CODEC_STATS_ENTER(buf);
+    CODEC_TRACE_ENTER();
+    buf->buffer = msg;
+    buf->totallen = totallen;
+    buf->curbyte = 0;
+    buf->error = CODEC_OK;
+    buf->order = CODEC_BYTEORDER;
+
+    if(mode == CODEC_ENCODE && msg != NULL)
+    {
+        memset(buf->buffer, 0, totallen);
+    }
+}
+
+void bytes_setorder(T_ByteStream *buf, unsigned short order)
+{
+    buf->order = order;
+}
+
+void bytes_forward(T_ByteStream *buf, unsigned short n)
+{
+    if(buf->curbyte + n >= buf->totallen)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_MOVETOOBITS);
+        buf->error = CODEC_MOVETOOBITS;
+        return;
+    }
+
+    buf->curbyte += n;
+
+}
+
+void bytes_back(T_ByteStream *buf, unsigned short n)
+{
+    if(buf->curbyte < n)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_MOVETOOBITS);
+        buf->error = CODEC_MOVETOOBITS;
+        return;
+    }
+
+    buf->curbyte -= n;
+}
+
+unsigned short bytes_geterror(T_ByteStream *buf)
+{
+    return buf->error;
+}
+
+unsigned short bytes_getlen(T_ByteStream *buf)
+{
+    return buf->curbyte;
+}
+
+unsigned short bytes_getcurpos(T_ByteStream *buf)
+{
+    return buf->curbyte;
+}
+
+unsigned char * bytes_getbuf(T_ByteStream *buf)
+{
+    return buf->buffer;
+}
+
+unsigned char bytes_getbyte(T_ByteStream *buf)
+{
+    unsigned char r = 0;
+
+    if(buf->curbyte + 1 > buf->totallen)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_GETTOOBITS);
+        buf->error = CODEC_GETTOOBITS;
+        return 0;
+    }
+
+    r = buf->buffer[buf->curbyte];
+    buf->curbyte ++;
+    return r;
+}
+
+unsigned short bytes_getword(T_ByteStream *buf)
+{
+    unsigned char *p;
+
+    if(buf->curbyte + 2 > buf->totallen)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_GETTOOBITS);
+        buf->error = CODEC_GETTOOBITS;
+        return 0;
+    }
+
+    p = &buf->buffer[buf->curbyte];
+    buf->curbyte += 2;
+
+    if(buf->order == CODEC_LITTLE_ENDIAN)
+        return (p[1]<<8) | p[0];
+
+    return (p[0]<<8) | p[1];
+}
+
+unsigned int bytes_getdword(T_ByteStream *buf)
+{
+    unsigned char *p;
+
+    if(buf->curbyte + 4 > buf->totallen)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_GETTOOBITS);
+        buf->error = CODEC_GETTOOBITS;
+        return 0;
+    }
+
+    p = &buf->buffer[buf->curbyte];
+    buf->curbyte += 4;
+
+    if(buf->order == CODEC_LITTLE_ENDIAN)
+        return ((unsigned int)p[3]<<24) | (p[2]<<16) | (p[1]<<8) | p[0];
+
+    return ((unsigned int)p[0]<<24) | (p[1]<<16) | (p[2]<<8) | p[3];
+}
+
+void bytes_getbitstream(T_ByteStream *bytes, unsigned short n, T_BitStream *bits)
+{
+    bits_init(bits, &bytes->buffer[bytes->curbyte], n, CODEC_DECODE);
+}
+
+void bytes_setbyte(T_ByteStream *buf, unsigned char value)
+{
+    if(buf->curbyte + 1 > buf->totallen)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_SETTOOBITS);
+        buf->error = CODEC_SETTOOBITS;
+        return;
+    }
+
+    if(buf->buffer != NULL)
+        buf->buffer[buf->curbyte] = value;
+    buf->curbyte ++;
+    return;
+}
+
+void bytes_setword(T_ByteStream *buf, unsigned short value)
+{
+    if(buf->curbyte + 2 > buf->totallen)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_SETTOOBITS);
+        buf->error = CODEC_SETTOOBITS;
+        return;
+    }
+
+    bytes_setwordbypos(buf, buf->curbyte, value);
+    buf->curbyte += 2;
+    return;
+
+}
+
+void bytes_setdword(T_ByteStream *buf, unsigned int value)
+{
+    if(buf->curbyte + 4 > buf->totallen)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_SETTOOBITS);
+        buf->error = CODEC_SETTOOBITS;
+        return;
+    }
+
+    bytes_setdwordbypos(buf, buf->curbyte, value);
+    buf->curbyte += 4;
+    return;
+
+}
+
+void bytes_setbyteslice(T_ByteStream *buf, unsigned char begin, unsigned char end, unsigned char value)
+{
+    unsigned char temp = 0;
+
+    if(begin < end)
+    {
+        temp = begin;
+        begin = end;
+        end = temp;
+    }
+
+    if(begin > 7)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_SETTOOBITS);
+        buf->error = CODEC_SETTOOBITS;
+        begin = 7;
+    }
+
+    if(buf->curbyte == 0 || buf->buffer == NULL)
+        return;
+
+    setbyteslice(&buf->buffer[buf->curbyte - 1], begin, end, value);
+    return;
+}
+
+void bytes_setbytebypos(T_ByteStream *buf, unsigned short pos, unsigned char value)
+{
+    if(pos + 1 > buf->totallen)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_SETTOOBITS);
+        buf->error = CODEC_SETTOOBITS;
+        return;
+    }
+
+    if(buf->buffer != NULL)
+        buf->buffer[pos] = value;
+    return;
+}
+
+void bytes_setwordbypos(T_ByteStream *buf, unsigned short pos, unsigned short value)
+{
+    unsigned char *p;
+
+    if(pos + 2 > buf->totallen)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_SETTOOBITS);
+        buf->error = CODEC_SETTOOBITS;
+        return;
+    }
+
+    if(buf->buffer == NULL)
+        return;
+
+    p = &buf->buffer[pos];
+    if(buf->order == CODEC_LITTLE_ENDIAN)
+    {
+        p[0] = value & 0xFF;
+        p[1] = value >> 8;
+        return;
+    }
+
+    p[0] = value >> 8;
+    p[1] = value & 0xFF;
+    return;
+}
+
+void bytes_setdwordbypos(T_ByteStream *buf, unsigned short pos, unsigned int value)
+{
+    unsigned char *p;
+
+    if(pos + 4 > buf->totallen)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_SETTOOBITS);
+        buf->error = CODEC_SETTOOBITS;
+        return;
+    }
+
+    if(buf->buffer == NULL)
+        return;
+
+    p = &buf->buffer[pos];
+    if(buf->order == CODEC_LITTLE_ENDIAN)
+    {
+        p[0] = value & 0xFF;
+        p[1] = (value >> 8) & 0xFF;
+        p[2] = (value >> 16) & 0xFF;
+        p[3] = value >> 24;
+        return;
+    }
+
+    p[0] = value >> 24;
+    p[1] = (value >> 16) & 0xFF;
+    p[2] = (value >> 8) & 0xFF;
+    p[3] = value & 0xFF;
+    return;
+}
+
+
+/*bit stream*/
+void bits_init(T_BitStream *buf, unsigned char *msg, unsigned short totallen, unsigned char mode)
+{
+    CODEC_STATS_ENTER(buf);
+    CODEC_TRACE_ENTER();
+    buf->buffer = msg;
+    buf->totallen = totallen;
+    buf->curbyte = 0;
+    buf->curbit = 0;
+    buf->error = CODEC_OK;
+    buf->order = CODEC_BITORDER;
+
+    if(mode == CODEC_ENCODE && msg != NULL)
+    {
+        memset(buf->buffer, 0, totallen);
+    }
+}
+
+void bits_setorder(T_BitStream *buf, unsigned short order)
+{
+    buf->order = order;
+}
+
+void bits_forward(T_BitStream *buf, unsigned short n)
+{
+    unsigned short curbit, curbyte;
+
+    curbit = buf->curbit;
+    curbyte = buf->curbyte;
+
+    curbit += n;
+    curbyte = curbit >> 3;
+
+    if(curbit >= 8 * buf->totallen)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_MOVETOOBITS);
+        buf->error = CODEC_MOVETOOBITS;
+        return;
+    }
+
+    buf->curbit = curbit;
+    buf->curbyte = curbyte;
+
+}
+
+void bits_back(T_BitStream *buf, unsigned short n)
+{
+    if(buf->curbit < n)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_MOVETOOBITS);
+        buf->error = CODEC_MOVETOOBITS;
+        return;
+    }
+
+    buf->curbit -= n;
+    buf->curbyte = buf->curbit >> 3;
+}
+
+unsigned short bits_geterror(T_BitStream *buf)
+{
+    return buf->error;
+}
+
+unsigned short bits_getlen(T_BitStream *buf)
+{
+    //return (buf->curbit % 8 == 0) ? buf->curbyte : (buf->curbyte + 1);
+    return buf->curbit;
+}
+
+unsigned short bits_getcurpos(T_BitStream *buf)
+{
+    return buf->curbit;
+}
+
+unsigned char * bits_getbuf(T_BitStream *buf)
+{
+    return buf->buffer;
+}
+
+unsigned int bits_getbit(T_BitStream *buf, unsigned char n)
+{
+    unsigned short firstbit, lastbit;
+
+    if( n < 1)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_GETZEROBITS);
+        buf->error = CODEC_GETZEROBITS;
+        return 0;
+    }
+
+    if(n > 32)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_GETTOOBITS);
+        buf->error = CODEC_GETTOOBITS;
+        return 0;
+    }
+
+    firstbit = buf->curbit;
+    lastbit = buf->curbit + n;
+    if(lastbit > 8 * buf->totallen)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_GETTOOBITS);
+        buf->error = CODEC_GETTOOBITS;
+        return 0;
+    }
+
+    buf->curbit = lastbit;
+    buf->curbyte = lastbit >> 3;
+
+    if(buf->order != CODEC_BITORDER)
+        return bits_getother(buf->buffer, firstbit, n);
+
+    return bits_getnative(buf->buffer, firstbit, n);
+}
+
+/*the next n bits without moving, 0 and no error when fewer are left*/
+unsigned int bits_peek(T_BitStream *buf, unsigned char n)
+{
+    T_BitStream probe;
+
+    if(n < 1 || n > 32 || buf->curbit + n > 8 * buf->totallen)
+        return 0;
+
+    probe = *buf;
+    return bits_getbit(&probe, n);
+}
+
+/*MSB-first: the first bit of the field is bit 7 of its byte and the top bit of the value*/
+unsigned int bits_getmsb(const unsigned char *msg, unsigned short pos, unsigned char n)
+{
+    unsigned short firstbyte = pos >> 3, lastbit = pos + n - 1, lastbyte = lastbit >> 3;
+    unsigned char offset1, offset2, offset;
+    int i;
+    unsigned int r = 0;
+    unsigned char count = 0;      /*1-5*/
+    unsigned char bytes[8] = {0};
+
+    if(firstbyte == lastbyte)
+    {
+        offset1 = 7 - pos % 8;
+        offset2 = 7 - lastbit % 8;
+        return getbyteslice(msg[firstbyte], offset1, offset2);
+    }
+
+    for(i=firstbyte, count=0; i<=lastbyte; i++, count++)
+        bytes[count] = msg[i];
+
+    bytes[0] = getbytelow(bytes[0], 8 - pos % 8);
+    bytes[count - 1] = getbytehi(bytes[count - 1], lastbit % 8 + 1);
+
+    /*whole middle bytes shift by 8, only the last byte is partial*/
+    offset = lastbit % 8 + 1;
+    for(i=0, r=bytes[0]; i<count-1; i++)
+    {
+        r = (r << (i == count - 2 ? offset : 8)) + bytes[i+1];
+    }
+
+    return r;
+}
+
+/*LSB-first: the first bit of the field is bit 0 of its byte and of the value*/
+unsigned int bits_getlsb(const unsigned char *msg, unsigned short pos, unsigned char n)
+{
+    const unsigned char *p = &msg[pos >> 3];
+    unsigned char got = 8 - (pos & 7);
+    unsigned int r = p[0] >> (pos & 7);
+
+    while(got < n)
+    {
+        p ++;
+        r |= (unsigned int)p[0] << got;
+        got += 8;
+    }
+
+    return r & highmask[n - 1];
+}
+
+/*
+ * Streams in the order init gives, CODEC_BITORDER, go through the kernel
+ * the accessors inline. The other order costs one predicted compare and a
+ * call out of line, so the native path compiles as if the order were fixed.
+ */
+unsigned int bits_getnative(const unsigned char *msg, unsigned short pos, unsigned char n)
+{
+#if CODEC_BITORDER == CODEC_LSB_FIRST
+    return bits_getlsb(msg, pos, n);
+#else
+    return bits_getmsb(msg, pos, n);
+#endif
+}
+
+unsigned int bits_getother(const unsigned char *msg, unsigned short pos, unsigned char n)
+{
+#if CODEC_BITORDER == CODEC_LSB_FIRST
+    return bits_getmsb(msg, pos, n);
+#else
+    return bits_getlsb(msg, pos, n);
+#endif
+}
+
+unsigned char bits_getbyte(T_BitStream *buf)
+{
+    return bits_getbit(buf, 8);
+}
+
+unsigned short bits_getword(T_BitStream *buf)
+{
+    return bits_getbit(buf, 16);
+}
+
+unsigned int bits_getdword(T_BitStream *buf)
+{
+    return bits_getbit(buf, 32);
+}
+
+unsigned char bits_popcount(unsigned long long x)
+{
+#if defined(__GNUC__) && (defined(__POPCNT__) || defined(__aarch64__))
+    return (unsigned char)__builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ULL);
+    x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0fULL;
+    return (unsigned char)((x * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+/*the 8 bytes from p on, p[0] in the top bits*/
+unsigned long long bits_loadmsb(const unsigned char *p)
+{
+    unsigned long long w;
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(&w, p, 8);
+    return __builtin_bswap64(w);
+#else
+    int i;
+
+    for(i = 0, w = 0; i < 8; i++)
+        w = w << 8 | p[i];
+    return w;
+#endif
+}
+
+/*the 8 bytes from p on, p[0] in the low bits*/
+unsigned long long bits_loadlsb(const unsigned char *p)
+{
+    unsigned long long w;
+#if defined(__GNUC__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    memcpy(&w, p, 8);
+    return w;
+#else
+    int i;
+
+    for(i = 7, w = 0; i >= 0; i--)
+        w = w << 8 | p[i];
+    return w;
+#endif
+}
+
+/*
+ * One bit order each, returning the bit after the first match or 0. While
+ * 8 bytes can be loaded from the byte a window starts in, the windows at
+ * all 8 bit offsets of that byte are compared against one loaded word,
+ * with the pattern and mask shifted to each offset once per call. That
+ * needs width + 7 <= 64, wider patterns and the last 7 bytes slide one bit
+ * at a time.
+ */
+unsigned int bits_findmsb(T_BitStream *buf, unsigned long long pattern, unsigned char width, unsigned char maxerrors)
+{
+    unsigned long long mask = width == 64 ? ~0ULL : (1ULL << width) - 1, window = 0, word, diff;
+    unsigned long long pats[8], masks[8];
+    unsigned int pos = buf->curbit, end = 8 * buf->totallen, have = 0, byte;
+    unsigned char bits, i, k;
+
+    /*the window at offset k is the word's bits 63 - k down to 64 - width - k*/
+    for(k = 0; width <= 57 && k < 8; k++)
+    {
+        pats[k] = pattern << (64 - width - k);
+        masks[k] = mask << (64 - width - k);
+    }
+
+    for(byte = pos >> 3; width <= 57 && byte + 8 <= buf->totallen; byte++, pos = 8 * byte)
+    {
+        word = bits_loadmsb(&buf->buffer[byte]);
+        CODEC_UNROLL8
+        for(k = 0; k < 8; k++)
+        {
+            diff = (word ^ pats[k]) & masks[k];
+            if((diff == 0 || (maxerrors > 0 && bits_popcount(diff) <= maxerrors)) && 8 * byte + k >= buf->curbit)
+                return 8 * byte + k + width;
+        }
+    }
+
+    for(; pos < end; )
+    {
+        bits = (unsigned char)(buf->buffer[pos >> 3] << (pos & 7));
+        for(i = pos & 7; i < 8; i++, bits <<= 1)
+        {
+            window = ((window << 1) | (bits >> 7)) & mask;
+            pos ++;
+            if(++have < width)
+                continue;
+
+            diff = window ^ pattern;
+            if(diff == 0 || (maxerrors > 0 && bits_popcount(diff) <= maxerrors))
+                return pos;
+        }
+    }
+
+    return 0;
+}
+
+unsigned int bits_findlsb(T_BitStream *buf, unsigned long long pattern, unsigned char width, unsigned char maxerrors)
+{
+    unsigned long long mask = width == 64 ? ~0ULL : (1ULL << width) - 1, window = 0, word, diff;
+    unsigned long long pats[8], masks[8];
+    unsigned int pos = buf->curbit, end = 8 * buf->totallen, have = 0, byte;
+    unsigned char bits, i, k;
+
+    /*the window at offset k is the word's bits k up to k + width - 1, the first bit read lowest*/
+    for(k = 0; width <= 57 && k < 8; k++)
+    {
+        pats[k] = pattern << k;
+        masks[k] = mask << k;
+    }
+
+    for(byte = pos >> 3; width <= 57 && byte + 8 <= buf->totallen; byte++, pos = 8 * byte)
+    {
+        word = bits_loadlsb(&buf->buffer[byte]);
+        CODEC_UNROLL8
+        for(k = 0; k < 8; k++)
+        {
+            diff = (word ^ pats[k]) & masks[k];
+            if((diff == 0 || (maxerrors > 0 && bits_popcount(diff) <= maxerrors)) && 8 * byte + k >= buf->curbit)
+                return 8 * byte + k + width;
+        }
+    }
+
+    for(; pos < end; )
+    {
+        bits = buf->buffer[pos >> 3] >> (pos & 7);
+        for(i = pos & 7; i < 8; i++, bits >>= 1)
+        {
+            /*the first bit read ends up in bit 0*/
+            window = (window >> 1) | ((unsigned long long)(bits & 1) << (width - 1));
+            pos ++;
+            if(++have < width)
+                continue;
+
+            diff = window ^ pattern;
+            if(diff == 0 || (maxerrors > 0 && bits_popcount(diff) <= maxerrors))
+                return pos;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Slide a width-bit window over the stream from the current bit and stop at
+ * the first position whose next width bits, read as ibits_getbit would,
+ * differ from pattern in at most maxerrors bits.
+ */
+unsigned short bits_findpattern(T_BitStream *buf, unsigned long long pattern, unsigned char width, unsigned char maxerrors)
+{
+    unsigned int next;
+
+    if(width < 1)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_GETZEROBITS);
+        buf->error = CODEC_GETZEROBITS;
+        return CODEC_NOPOS;
+    }
+
+    if(width > 64)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_GETTOOBITS);
+        buf->error = CODEC_GETTOOBITS;
+        return CODEC_NOPOS;
+    }
+
+    if(width < 64)
+        pattern &= (1ULL << width) - 1;
+
+    if(buf->order == CODEC_LSB_FIRST)
+        next = bits_findlsb(buf, pattern, width, maxerrors);
+    else
+        next = bits_findmsb(buf, pattern, width, maxerrors);
+
+    if(next == 0)
+        return CODEC_NOPOS;
+
+    buf->curbit = (unsigned short)(next - width);
+    buf->curbyte = buf->curbit >> 3;
+    return buf->curbit;
+}
+
+void bits_setbit(T_BitStream *buf, unsigned char len, unsigned int value)
+{
+    unsigned short firstbit, lastbit;
+
+    if( len < 1)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_SETZEROBITS);
+        buf->error = CODEC_SETZEROBITS;
+        return;
+    }
+
+    if(len > 32)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_SETTOOBITS);
+        buf->error = CODEC_SETTOOBITS;
+        return;
+    }
+
+    firstbit = buf->curbit;
+    lastbit = buf->curbit + len;
+    if(lastbit > 8 * buf->totallen)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_SETTOOBITS);
+        buf->error = CODEC_SETTOOBITS;
+        return;
+    }
+
+    buf->curbit = lastbit;
+    buf->curbyte = lastbit >> 3;
+
+    if(buf->buffer == NULL)
+        return;
+
+    if(buf->order != CODEC_BITORDER)
+    {
+        bits_setother(buf->buffer, firstbit, len, value);
+        return;
+    }
+
+    bits_setnative(buf->buffer, firstbit, len, value);
+}
+
+/*MSB-first: the top bit of the value goes to bit 7 - pos % 8 of the first byte*/
+void bits_setmsb(unsigned char *msg, unsigned short pos, unsigned char len, unsigned int value)
+{
+    unsigned short firstbyte = pos >> 3, lastbit = pos + len - 1, lastbyte = lastbit >> 3;
+    unsigned char remain, temp;
+    int i;
+    unsigned char begin, end;
+
+    remain = 8 - pos % 8;
+    if(remain >= len)
+    {
+        temp = (unsigned char)getintslice(value, len - 1, 0);
+        setbyteslice(&msg[firstbyte], remain - 1, remain - len, temp);
+        return;
+    }
+
+    begin = len - 1;
+    end = len - remain;
+    temp = (unsigned char)getintslice(value, begin, end);
+    setbyteslice(&msg[firstbyte], remain - 1, 0, temp);
+    begin = end - 1;
+    end = end > 8 ? end - 8 : 0;
+
+    for(i=firstbyte+1; i<=lastbyte; i++)
+    {
+        temp = (unsigned char)getintslice(value, begin, end);
+        if(i != lastbyte)
+        {
+            msg[i] = temp;
+        }
+        else
+        {
+            msg[i] = temp << (7 - lastbit % 8);
+            break;
+        }
+        begin = end - 1;
+        end = end > 8 ? end - 8 : 0;
+    }
+}
+
+void bits_setlsb(unsigned char *msg, unsigned short pos, unsigned char len, unsigned int value)
+{
+    unsigned char *p = &msg[pos >> 3];
+    unsigned char shift = pos & 7;
+    unsigned char take, mask;
+
+    value &= highmask[len - 1];
+    while(len > 0)
+    {
+        take = 8 - shift < len ? 8 - shift : len;
+        mask = (unsigned char)(highmask[take - 1] << shift);
+        *p = (*p & ~mask) | ((unsigned char)(value << shift) & mask);
+        value >>= take;
+        len -= take;
+        shift = 0;
+        p ++;
+    }
+}
+
+void bits_setnative(unsigned char *msg, unsigned short pos, unsigned char len, unsigned int value)
+{
+#if CODEC_BITORDER == CODEC_LSB_FIRST
+    bits_setlsb(msg, pos, len, value);
+#else
+    bits_setmsb(msg, pos, len, value);
+#endif
+}
+
+void bits_setother(unsigned char *msg, unsigned short pos, unsigned char len, unsigned int value)
+{
+#if CODEC_BITORDER == CODEC_LSB_FIRST
+    bits_setmsb(msg, pos, len, value);
+#else
+    bits_setlsb(msg, pos, len, value);
+#endif
+}
+
+void bits_setbyte(T_BitStream *buf, unsigned char value)
+{
+    bits_setbit(buf, 8, value);
+}
+
+void bits_setword(T_BitStream *buf, unsigned short value)
+{
+    bits_setbit(buf, 16, value);
+}
+
+void bits_setdword(T_BitStream *buf, unsigned int value)
+{
+    bits_setbit(buf, 32, value);
+}
+
+void bits_setbitbypos(T_BitStream *buf, unsigned short pos, unsigned char len, unsigned int value)
+{
+    if( len < 1)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_SETZEROBITS);
+        buf->error = CODEC_SETZEROBITS;
+        return;
+    }
+
+    if(len > 32)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_SETTOOBITS);
+        buf->error = CODEC_SETTOOBITS;
+        return;
+    }
+
+    if(pos + len > 8 * buf->totallen)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_SETTOOBITS);
+        buf->error = CODEC_SETTOOBITS;
+        return;
+    }
+
+    if(buf->buffer == NULL)
+        return;
+
+    if(buf->order != CODEC_BITORDER)
+    {
+        bits_setother(buf->buffer, pos, len, value);
+        return;
+    }
+
+    bits_setnative(buf->buffer, pos, len, value);
+}
+
+void bits_setbytebypos(T_BitStream *buf, unsigned short pos, unsigned char value)
+{
+    if(pos + 8 > 8 * buf->totallen)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_SETTOOBITS);
+        buf->error = CODEC_SETTOOBITS;
+        return;
+    }
+
+    bits_setbitbypos(buf, pos, 8, value);
+    return;
+}
+
+/*a word or dword written MSB-first is its bytes high to low, so both orders are one field*/
+void bits_setwordbypos(T_BitStream *buf, unsigned short pos, unsigned short value)
+{
+    if(pos + 16 > 8 * buf->totallen)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_SETTOOBITS);
+        buf->error = CODEC_SETTOOBITS;
+        return;
+    }
+
+    bits_setbitbypos(buf, pos, 16, value);
+    return;
+}
+
+void bits_setdwordbypos(T_BitStream *buf, unsigned short pos, unsigned int value)
+{
+    if(pos + 32 > 8 * buf->totallen)
+    {
+        CODEC_STATS_ERROR(buf, CODEC_SETTOOBITS);
+        buf->error = CODEC_SETTOOBITS;
+        return;
+    }
+
+    bits_setbitbypos(buf, pos, 32, value);
+    return;
+}
+
+/*input byte stream function*/
+void ibytes_init(T_InputByteStream *buf, unsigned char *msg, unsigned short totallen)
+{
+    bytes_init(&buf->bytes, msg, totallen, CODEC_DECODE);
+}
+
+void ibytes_setorder(T_InputByteStream *buf, unsigned short order)
+{
+    bytes_setorder(&buf->bytes, order);
+}
+
+void ibytes_forward(T_InputByteStream *buf, unsigned short n)
+{
+    CODEC_STATS_MOVE(&buf->bytes, IBYTES_FORWARD, 8u * n);
+    CODEC_TRACE_PUT(IBYTES_FORWARD, &buf->bytes, buf->bytes.curbyte, 0, n);
+    bytes_forward(&buf->bytes, n);
+}
+
+void ibytes_back(T_InputByteStream *buf, unsigned short n)
+{
+    CODEC_STATS_MOVE(&buf->bytes, IBYTES_BACK, 8u * n);
+    CODEC_TRACE_PUT(IBYTES_BACK, &buf->bytes, buf->bytes.curbyte, 0, n);
+    bytes_back(&buf->bytes, n);
+}
+
+unsigned short ibytes_geterror(T_InputByteStream *buf)
+{
+    return bytes_geterror(&buf->bytes);
+}
+
+unsigned short ibytes_getlen(T_InputByteStream *buf)
+{
+    return bytes_getlen(&buf->bytes);
+}
+
+unsigned short ibytes_getcurpos(T_InputByteStream *buf)
+{
+    return bytes_getcurpos(&buf->bytes);
+}
+
+unsigned char ibytes_getbyte(T_InputByteStream *buf)
+{
+    CODEC_STATS_COUNT(&buf->bytes, IBYTES_GETBYTE);
+    CODEC_TRACE_GET(IBYTES_GETBYTE, &buf->bytes, buf->bytes.curbyte, 8, unsigned char, bytes_getbyte(&buf->bytes))
+}
+
+unsigned short ibytes_getword(T_InputByteStream *buf)
+{
+    CODEC_STATS_COUNT(&buf->bytes, IBYTES_GETWORD);
+    CODEC_TRACE_GET(IBYTES_GETWORD, &buf->bytes, buf->bytes.curbyte, 16, unsigned short, bytes_getword(&buf->bytes))
+}
+
+unsigned int ibytes_getdword(T_InputByteStream *buf)
+{
+    CODEC_STATS_COUNT(&buf->bytes, IBYTES_GETDWORD);
+    CODEC_TRACE_GET(IBYTES_GETDWORD, &buf->bytes, buf->bytes.curbyte, 32, unsigned int, bytes_getdword(&buf->bytes))
+}
+
+void ibytes_getbitstream(T_InputByteStream *bytes, unsigned short n, T_InputBitStream *bits)
+{
+    bytes_getbitstream(&bytes->bytes, n, &bits->bits);
+}
+
+/*output byte stream function*/
+void obytes_init(T_OutputByteStream *buf, unsigned char *msg, unsigned short totallen)
+{
+    bytes_init(&buf->bytes, msg, totallen, CODEC_ENCODE);
+}
+
+void obytes_setorder(T_OutputByteStream *buf, unsigned short order)
+{
+    bytes_setorder(&buf->bytes, order);
+}
+
+unsigned short obytes_geterror(T_OutputByteStream *buf)
+{
+    return bytes_geterror(&buf->bytes);
+}
+
+unsigned short obytes_getlen(T_OutputByteStream *buf)
+{
+    return bytes_getlen(&buf->bytes);
+}
+
+unsigned short obytes_getcurpos(T_OutputByteStream *buf)
+{
+    return bytes_getcurpos(&buf->bytes);
+}
+
+void obytes_setbyte(T_OutputByteStream *buf, unsigned char value)
+{
+    CODEC_STATS_COUNT(&buf->bytes, OBYTES_SETBYTE);
+    CODEC_TRACE_PUT(OBYTES_SETBYTE, &buf->bytes, buf->bytes.curbyte, 8, value);
+    bytes_setbyte(&buf->bytes, value);
+}
+
+void obytes_setword(T_OutputByteStream *buf, unsigned short value)
+{
+    CODEC_STATS_COUNT(&buf->bytes, OBYTES_SETWORD);
+    CODEC_TRACE_PUT(OBYTES_SETWORD, &buf->bytes, buf->bytes.curbyte, 16, value);
+    bytes_setword(&buf->bytes, value);
+}
+
+void obytes_setdword(T_OutputByteStream *buf, unsigned int value)
+{
+    CODEC_STATS_COUNT(&buf->bytes, OBYTES_SETDWORD);
+    CODEC_TRACE_PUT(OBYTES_SETDWORD, &buf->bytes, buf->bytes.curbyte, 32, value);
+    bytes_setdword(&buf->bytes, value);
+}
+
+void obytes_setbyteslice(T_OutputByteStream *buf, unsigned char begin, unsigned char end, unsigned char value)
+{
+    CODEC_STATS_COUNT(&buf->bytes, OBYTES_SETBYTESLICE);
+    CODEC_TRACE_PUT(OBYTES_SETBYTESLICE, &buf->bytes, buf->bytes.curbyte, begin - end + 1, value);
+    bytes_setbyteslice(&buf->bytes, begin, end, value);
+}
+
+void obytes_setbytebypos(T_OutputByteStream *buf, unsigned short pos, unsigned char value)
+{
+    CODEC_STATS_COUNT(&buf->bytes, OBYTES_SETBYTEBYPOS);
+    CODEC_TRACE_PUT(OBYTES_SETBYTEBYPOS, &buf->bytes, pos, 8, value);
+    bytes_setbytebypos(&buf->bytes, pos, value);
+}
+
+void obytes_setwordbypos(T_OutputByteStream *buf, unsigned short pos, unsigned short value)
+{
+    CODEC_STATS_COUNT(&buf->bytes, OBYTES_SETWORDBYPOS);
+    CODEC_TRACE_PUT(OBYTES_SETWORDBYPOS, &buf->bytes, pos, 16, value);
+    bytes_setwordbypos(&buf->bytes, pos, value);
+}
+
+void obytes_setdwordbypos(T_OutputByteStream *buf, unsigned short pos, unsigned int value)
+{
+    CODEC_STATS_COUNT(&buf->bytes, OBYTES_SETDWORDBYPOS);
+    CODEC_TRACE_PUT(OBYTES_SETDWORDBYPOS, &buf->bytes, pos, 32, value);
+    bytes_setdwordbypos(&buf->bytes, pos, value);
+}
+
+unsigned char * obytes_getbuf(T_OutputByteStream *buf)
+{
+    return bytes_getbuf(&buf->bytes);
+}
+
+/*input bit stream function*/
+void ibits_init(T_InputBitStream *buf, unsigned char *msg, unsigned short totallen)
+{
+    bits_init(&buf->bits, msg, totallen, CODEC_DECODE);
+}
+
+void ibits_setorder(T_InputBitStream *buf, unsigned short order)
+{
+    bits_setorder(&buf->bits, order);
+}
+
+void ibits_forward(T_InputBitStream *buf, unsigned short n)
+{
+    CODEC_STATS_MOVE(&buf->bits, IBITS_FORWARD, n);
+    CODEC_TRACE_PUT(IBITS_FORWARD, &buf->bits, buf->bits.curbit, 0, n);
+    bits_forward(&buf->bits, n);
+}
+
+void ibits_back(T_InputBitStream *buf, unsigned short n)
+{
+    CODEC_STATS_MOVE(&buf->bits, IBITS_BACK, n);
+    CODEC_TRACE_PUT(IBITS_BACK, &buf->bits, buf->bits.curbit, 0, n);
+    bits_back(&buf->bits, n);
+}
+
+void ibits_save(T_InputBitStream *buf, T_BitMark *mark)
+{
+    mark->curbyte = buf->bits.curbyte;
+    mark->curbit = buf->bits.curbit;
+    mark->error = buf->bits.error;
+    mark->order = buf->bits.order;
+}
+
+void ibits_restore(T_InputBitStream *buf, const T_BitMark *mark)
+{
+    buf->bits.curbyte = mark->curbyte;
+    buf->bits.curbit = mark->curbit;
+    buf->bits.error = mark->error;
+    buf->bits.order = mark->order;
+}
+
+unsigned short ibits_geterror(T_InputBitStream *buf)
+{
+    return bits_geterror(&buf->bits);
+}
+
+unsigned short ibits_getlen(T_InputBitStream *buf)
+{
+    return bits_getlen(&buf->bits);
+}
+
+unsigned short ibits_getcurpos(T_InputBitStream *buf)
+{
+    return bits_getcurpos(&buf->bits);
+}
+
+unsigned int ibits_getbit(T_InputBitStream *buf, unsigned char n)
+{
+    CODEC_STATS_COUNT(&buf->bits, IBITS_GETBIT);
+    CODEC_TRACE_GET(IBITS_GETBIT, &buf->bits, buf->bits.curbit, n, unsigned int, bits_getbit(&buf->bits, n))
+}
+
+unsigned int ibits_peek(T_InputBitStream *buf, unsigned char n)
+{
+    CODEC_STATS_COUNT(&buf->bits, IBITS_PEEK);
+    CODEC_TRACE_GET(IBITS_PEEK, &buf->bits, buf->bits.curbit, n, unsigned int, bits_peek(&buf->bits, n))
+}
+
+unsigned char ibits_getbyte(T_InputBitStream *buf)
+{
+    CODEC_STATS_COUNT(&buf->bits, IBITS_GETBIT);
+    CODEC_TRACE_GET(IBITS_GETBIT, &buf->bits, buf->bits.curbit, 8, unsigned char, bits_getbyte(&buf->bits))
+}
+
+unsigned short ibits_getword(T_InputBitStream *buf)
+{
+    CODEC_STATS_COUNT(&buf->bits, IBITS_GETBIT);
+    CODEC_TRACE_GET(IBITS_GETBIT, &buf->bits, buf->bits.curbit, 16, unsigned short, bits_getword(&buf->bits))
+}
+
+unsigned int ibits_getdword(T_InputBitStream *buf)
+{
+    CODEC_STATS_COUNT(&buf->bits, IBITS_GETBIT);
+    CODEC_TRACE_GET(IBITS_GETBIT, &buf->bits, buf->bits.curbit, 32, unsigned int, bits_getdword(&buf->bits))
+}
+
+unsigned short ibits_findpattern(T_InputBitStream *buf, unsigned long long pattern, unsigned char width, unsigned char maxerrors)
+{
+    CODEC_STATS_COUNT(&buf->bits, IBITS_FINDPATTERN);
+    CODEC_TRACE_GET(IBITS_FINDPATTERN, &buf->bits, buf->bits.curbit, width, unsigned short, bits_findpattern(&buf->bits, pattern, width, maxerrors))
+}
+
+/*output bit stream function*/
+void obits_init(T_OutputBitStream *buf, unsigned char *msg, unsigned short totallen)
+{
+    bits_init(&buf->bits, msg, totallen, CODEC_ENCODE);
+}
+
+void obits_setorder(T_OutputBitStream *buf, unsigned short order)
+{
+    bits_setorder(&buf->bits, order);
+}
+
+unsigned short obits_geterror(T_OutputBitStream *buf)
+{
+    return bits_geterror(&buf->bits);
+}
+
+unsigned short obits_getlen(T_OutputBitStream *buf)
+{
+    return bits_getlen(&buf->bits);
+}
+
+unsigned short obits_getcurpos(T_OutputBitStream *buf)
+{
+    return bits_getcurpos(&buf->bits);
+}
+
+
+void obits_setbit(T_OutputBitStream *buf, unsigned char len, unsigned int value)
+{
+    CODEC_STATS_COUNT(&buf->bits, OBITS_SETBIT);
+    CODEC_TRACE_PUT(OBITS_SETBIT, &buf->bits, buf->bits.curbit, len, value);
+    bits_setbit(&buf->bits, len, value);
+}
+
+void obits_setbyte(T_OutputBitStream *buf, unsigned char value)
+{
+    CODEC_STATS_COUNT(&buf->bits, OBITS_SETBIT);
+    CODEC_TRACE_PUT(OBITS_SETBIT, &buf->bits, buf->bits.curbit, 8, value);
+    bits_setbyte(&buf->bits, value);
+}
+
+void obits_setword(T_OutputBitStream *buf, unsigned short value)
+{
+    CODEC_STATS_COUNT(&buf->bits, OBITS_SETBIT);
+    CODEC_TRACE_PUT(OBITS_SETBIT, &buf->bits, buf->bits.curbit, 16, value);
+    bits_setword(&buf->bits, value);
+}
+
+void obits_setdword(T_OutputBitStream *buf, unsigned int value)
+{
+    CODEC_STATS_COUNT(&buf->bits, OBITS_SETBIT);
+    CODEC_TRACE_PUT(OBITS_SETBIT, &buf->bits, buf->bits.curbit, 32, value);
+    bits_setdword(&buf->bits, value);
+}
+
+void obits_setbitbypos(T_OutputBitStream *buf, unsigned short pos, unsigned char len, unsigned int value)
+{
+    CODEC_STATS_COUNT(&buf->bits, OBITS_SETBITBYPOS);
+    CODEC_TRACE_PUT(OBITS_SETBITBYPOS, &buf->bits, pos, len, value);
+    bits_setbitbypos(&buf->bits, pos, len, value);
+}
+
+void obits_setbytebypos(T_OutputBitStream *buf, unsigned short pos, unsigned char value)
+{
+    CODEC_STATS_COUNT(&buf->bits, OBITS_SETBITBYPOS);
+    CODEC_TRACE_PUT(OBITS_SETBITBYPOS, &buf->bits, pos, 8, value);
+    bits_setbytebypos(&buf->bits, pos, value);
+}
+
+void obits_setwordbypos(T_OutputBitStream *buf, unsigned short pos, unsigned short value)
+{
+    CODEC_STATS_COUNT(&buf->bits, OBITS_SETBITBYPOS);
+    CODEC_TRACE_PUT(OBITS_SETBITBYPOS, &buf->bits, pos, 16, value);
+    bits_setwordbypos(&buf->bits, pos, value);
+}
+
+void obits_setdwordbypos(T_OutputBitStream *buf, unsigned short pos, unsigned int value)
+{
+    CODEC_STATS_COUNT(&buf->bits, OBITS_SETBITBYPOS);
+    CODEC_TRACE_PUT(OBITS_SETBITBYPOS, &buf->bits, pos, 32, value);
+    bits_setdwordbypos(&buf->bits, pos, value);
+}
+
+unsigned char * obits_getbuf(T_OutputBitStream *buf)
+{
+    return bits_getbuf(&buf->bits);
+}
+
+#endif
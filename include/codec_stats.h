@@ -0,0 +1,124 @@
+/*outside the guard: in the header-only build codec.h pulls this file back in*/
+#include "codec.h"
+
+#ifndef CODEC_STATS_H
+#define CODEC_STATS_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Optional instrumentation of the stream layer, compiled in by defining
+ * CODEC_STATS for codec.c, codec_stats.c and the callers, since it adds a
+ * stats member to the streams. A thread gets its own block the first time
+ * it initializes a stream and the stream keeps a pointer to it, so the hot
+ * path is one plain increment through that pointer, with no thread-local
+ * lookup, atomic or branch. codec_stats_snapshot sums every block without
+ * stopping the writers, and may see a block a few increments behind. A
+ * stream used by another thread than the one that initialized it keeps
+ * counting into that thread's block and may lose increments. Calls are
+ * counted per primitive only: a second increment for the width of the
+ * per-bit calls cost as much again on accessor-bound loops, so bits are
+ * known for moves and the fixed-width byte calls but not for the bit
+ * reads and writes. Every message between CODEC_STATS_BEGIN and
+ * CODEC_STATS_END is counted, but only one in CODEC_STATS_SAMPLE per thread
+ * is timed into the latency histograms, as reading the cycle counter can
+ * cost as much as a short message's decode. Without CODEC_STATS the hooks
+ * and the CODEC_STATS_BEGIN/END macros expand to nothing.
+ */
+#define CODEC_STATS_ERRORS   6     /*CODEC_OK .. CODEC_SETZEROBITS*/
+#define CODEC_STATS_TAGS     64    /*message types for latency histograms*/
+#define CODEC_STATS_BUCKETS  40    /*bucket b holds latencies of 2^b to 2^(b+1)-1 cycles*/
+
+#ifndef CODEC_STATS_SAMPLE
+#define CODEC_STATS_SAMPLE   16    /*messages per timed one, a power of two*/
+#endif
+
+typedef struct tagT_CodecStats {
+    unsigned long long calls[CODEC_OPS];
+    unsigned long long moved[CODEC_OPS];          /*bits skipped by forward/back*/
+    unsigned long long errors[CODEC_STATS_ERRORS];
+    unsigned long long messages[CODEC_STATS_TAGS];
+    unsigned long long latency[CODEC_STATS_TAGS][CODEC_STATS_BUCKETS];  /*timed messages only*/
+    unsigned long long cycles[CODEC_STATS_TAGS];               /*total of the timed ones per tag*/
+    unsigned long long started;                                /*timestamp of the open message, 0 if untimed*/
+    unsigned int tag;
+    unsigned int seq;                                          /*messages begun, picks the timed ones*/
+    struct tagT_CodecStats *next;
+} T_CodecStats;
+
+#ifdef CODEC_STATS
+
+#if defined(__GNUC__)
+#define CODEC_STATS_TLS __thread
+#else
+#define CODEC_STATS_TLS _Thread_local
+#endif
+
+extern CODEC_STATS_TLS T_CodecStats *codec_stats_self;
+extern T_CodecStats codec_stats_shared;
+
+T_CodecStats *codec_stats_attach(void);
+unsigned long long codec_stats_clock(void);
+void codec_stats_time(T_CodecStats *s);
+void codec_stats_snapshot(T_CodecStats *out);
+unsigned long long codec_stats_bits(const T_CodecStats *stats, unsigned int prim);
+void codec_stats_print(const T_CodecStats *stats, FILE *f);
+
+/*called from every stream init, gives the thread its own block and the stream its pointer*/
+static CODEC_INLINE T_CodecStats *codec_stats_enter(void)
+{
+    T_CodecStats *s = codec_stats_self;
+    return s != &codec_stats_shared ? s : codec_stats_attach();
+}
+
+/*failed calls are counted too*/
+static CODEC_INLINE void codec_stats_count(T_CodecStats *s, unsigned int prim)
+{
+    s->calls[prim] ++;
+}
+
+static CODEC_INLINE void codec_stats_move(T_CodecStats *s, unsigned int prim, unsigned int bits)
+{
+    s->calls[prim] ++;
+    s->moved[prim] += bits;
+}
+
+static CODEC_INLINE void codec_stats_error(T_CodecStats *s, unsigned short code)
+{
+    s->errors[code < CODEC_STATS_ERRORS ? code : 0] ++;
+}
+
+static CODEC_INLINE void codec_stats_begin(unsigned int tag)
+{
+    T_CodecStats *s = codec_stats_enter();
+
+    s->tag = tag < CODEC_STATS_TAGS ? tag : CODEC_STATS_TAGS - 1;
+    s->messages[s->tag] ++;
+    s->started = (s->seq++ & (CODEC_STATS_SAMPLE - 1)) == 0 ? codec_stats_clock() : 0;
+}
+
+static CODEC_INLINE void codec_stats_end(void)
+{
+    if(codec_stats_self->started != 0)
+        codec_stats_time(codec_stats_self);
+}
+
+#define CODEC_STATS_BEGIN(tag)  codec_stats_begin(tag)
+#define CODEC_STATS_END()       codec_stats_end()
+
+#else
+
+#define CODEC_STATS_BEGIN(tag)
+#define CODEC_STATS_END()
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,123 @@
+/*outside the guard: in the header-only build codec.h pulls this file back in*/
+#include "codec.h"
+
+#ifndef CODEC_TRACE_H
+#define CODEC_TRACE_H
+
+#include <stdio.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Optional binary trace of the stream layer, compiled in by defining
+ * CODEC_TRACE for codec.c, codec_trace.c and the callers. Every accessor
+ * call appends a 16-byte event to a ring owned by the calling thread;
+ * codec_trace_dump drains all rings to a file that tools/codec_tracedump
+ * renders as text or JSON. A full ring drops events and counts them
+ * rather than blocking the decoder. A thread that calls accessors before
+ * initializing any stream of its own, on a stream another thread made,
+ * has no ring yet: its events are dropped without being counted.
+ */
+#ifndef CODEC_TRACE_EVENTS
+#define CODEC_TRACE_EVENTS  65536   /*per thread, power of two*/
+#endif
+
+#define CODEC_TRACE_MAGIC    "CODECTRC"
+#define CODEC_TRACE_VERSION  1
+
+/*
+ * pos is in bits for bit streams and bytes for byte streams, before the
+ * call. value is what was read or written, the distance moved for
+ * forward/back and the match position for findpattern.
+ */
+typedef struct tagT_TraceEvent {
+    unsigned long long stream;    /*address of the stream*/
+    unsigned int value;
+    unsigned short pos;
+    unsigned char width;
+    unsigned char op;             /*CODEC_OP_*/
+} T_TraceEvent;
+
+/*
+ * Dump file: magic, version and event size as two 32-bit words, then
+ * blocks of a T_TraceBlock followed by count events, all in host order.
+ * Every dump starts with its own header, so a file may hold several and
+ * a header, the same size as a block, may stand where a block would.
+ */
+typedef struct tagT_TraceBlock {
+    unsigned int thread;
+    unsigned int count;
+    unsigned long long dropped;   /*events lost on this thread so far*/
+} T_TraceBlock;
+
+#ifdef CODEC_TRACE
+
+#if defined(__GNUC__)
+#define CODEC_TRACE_TLS __thread
+#else
+#define CODEC_TRACE_TLS _Thread_local
+#endif
+
+/*single producer (the owner thread), single consumer (codec_trace_dump)*/
+typedef struct tagT_TraceRing {
+    unsigned int head;            /*written by the producer*/
+    unsigned int limit;           /*producer's copy of tail + size*/
+    unsigned int size;
+    unsigned int thread;
+    unsigned long long dropped;
+    T_TraceEvent *events;
+    unsigned int tail;            /*written by the consumer*/
+    struct tagT_TraceRing *next;
+} T_TraceRing;
+
+extern CODEC_TRACE_TLS T_TraceRing *codec_trace_self;
+extern T_TraceRing codec_trace_none;
+
+T_TraceRing *codec_trace_attach(void);
+int codec_trace_dump(FILE *f);
+
+/*called from every stream init, gives the thread its own ring*/
+static CODEC_INLINE void codec_trace_enter(void)
+{
+    if(codec_trace_self == &codec_trace_none)
+        codec_trace_attach();
+}
+
+static CODEC_INLINE void codec_trace_event(unsigned char op, const void *stream, unsigned short pos,
+                                           unsigned char width, unsigned int value)
+{
+    T_TraceRing *r = codec_trace_self;
+    T_TraceEvent *e;
+
+    /*reload the consumer position only when the cached one says full*/
+    if(r->head == r->limit)
+    {
+        /*the shared fallback ring is always full and never written*/
+        if(r == &codec_trace_none)
+            return;
+        r->limit = __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) + r->size;
+        if(r->head == r->limit)
+        {
+            __atomic_store_n(&r->dropped, r->dropped + 1, __ATOMIC_RELAXED);
+            return;
+        }
+    }
+
+    e = &r->events[r->head & (r->size - 1)];
+    e->stream = (unsigned long long)(size_t)stream;
+    e->value = value;
+    e->pos = pos;
+    e->width = width;
+    e->op = op;
+    __atomic_store_n(&r->head, r->head + 1, __ATOMIC_RELEASE);
+}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
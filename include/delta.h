@@ -0,0 +1,48 @@
+#ifndef DELTA_H
+#define DELTA_H
+
+#include "codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*frame type, first byte of every encoded message*/
+#define DELTA_KEYFRAME  0     /*type, length word, message bytes*/
+#define DELTA_DIFF      1     /*type, length word, skip/literal runs against the reference*/
+
+/*results besides CODEC_OK and the stream errors*/
+#define DELTA_NOREF     16    /*diff received before any keyframe on the flow*/
+#define DELTA_CORRUPT   17    /*unknown frame type or runs past the message length*/
+
+/*
+ * Per-flow reference: the last message sent or received on the flow.
+ * Bytes past reflen are kept zero, so a longer message diffs against
+ * zero padding. Encoder and decoder each keep their own flow.
+ */
+typedef struct tagT_DeltaFlow {
+    unsigned char ref[MAX_CODEC_BUFFER_LEN];
+    unsigned short reflen;
+    unsigned short haveref;
+    unsigned short interval;    /*keyframe every interval messages, 0 only when needed*/
+    unsigned short sincekey;    /*messages since the last keyframe*/
+} T_DeltaFlow;
+
+/*
+ * A diff is a list of runs, each a LEB128 count of unchanged bytes, a
+ * LEB128 count of changed bytes, then the changed bytes XORed with the
+ * reference. The encoder sends a keyframe instead when the diff would not
+ * be smaller. The length word follows the byte order of the stream.
+ * Encoding or decoding into a counting stream (NULL buffer) still moves
+ * the flow on, so size a message against a copy of the flow; a decoder
+ * can also skip messages this way and stay in step.
+ */
+void delta_flowinit(T_DeltaFlow *flow, unsigned short interval);
+unsigned short delta_encode(T_DeltaFlow *flow, const unsigned char *msg, unsigned short len, T_OutputByteStream *out);
+unsigned short delta_decode(T_DeltaFlow *flow, T_InputByteStream *in, T_OutputByteStream *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef FRAMEFILE_H
+#define FRAMEFILE_H
+
+#include <stddef.h>
+#include "codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*results besides CODEC_OK*/
+#define FRAMEFILE_NOFILE    16    /*open, fstat or mmap failed, see errno*/
+#define FRAMEFILE_NOMEM     17    /*no memory for the index*/
+#define FRAMEFILE_BADFRAME  18    /*a length runs past the end of the file or MAX_CODEC_BUFFER_LEN*/
+
+#define FRAMEFILE_MAXTHREADS  64
+#define FRAMEFILE_WINDOW      (4u << 20)    /*bytes asked for ahead of the reader with MADV_WILLNEED*/
+
+/*
+ * Decodes one frame, msg covers exactly the frame body in the mapping.
+ * worker is 0 to nthreads-1, for per-thread state indexed by the caller.
+ */
+typedef unsigned short (*T_FrameDecode)(void *ctx, unsigned int worker, T_InputByteStream *msg);
+
+typedef struct tagT_FrameFile {
+    const unsigned char *data;
+    size_t size;
+    size_t *offsets;              /*of each frame body, the length is the two bytes before*/
+    unsigned int count;
+    size_t bad;                   /*offset of the first frame that failed the index, size if none*/
+    unsigned long failed;         /*frames decode did not return CODEC_OK for in the last run*/
+    int fd;                       /*-1 when attached to memory*/
+} T_FrameFile;
+
+/*
+ * A frame file is a sequence of records, each a 2-byte big-endian length
+ * then that many bytes. framefile_open maps the file read-only and
+ * indexes it in one pass; indexing stops at the first record that does
+ * not fit, returning FRAMEFILE_BADFRAME with the frames before it still
+ * usable. framefile_attach indexes a buffer the caller keeps alive.
+ */
+unsigned short framefile_open(T_FrameFile *ff, const char *path);
+unsigned short framefile_attach(T_FrameFile *ff, const unsigned char *data, size_t size);
+void framefile_close(T_FrameFile *ff);
+
+/*input stream over frame i in place; decoders must not write to it*/
+void framefile_frame(T_FrameFile *ff, unsigned int i, T_InputByteStream *msg);
+
+/*
+ * Runs decode over every frame on nthreads threads, each taking one
+ * contiguous run of frames holding about the same number of bytes, so
+ * every worker reads its part of the file sequentially. Parts a thread
+ * cannot be started for run on the calling thread.
+ */
+unsigned short framefile_run(T_FrameFile *ff, unsigned int nthreads, T_FrameDecode decode, void *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef HDLC_H
+#define HDLC_H
+
+#include "codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define HDLC_FLAG  0x7E
+
+/*hdlc_decodeframe result*/
+#define HDLC_NEEDMORE  0   /*input exhausted, call again with more input*/
+#define HDLC_FRAME     1   /*a complete frame was written to the output stream*/
+#define HDLC_ABORT     2   /*seven ones received, partial frame discarded*/
+#define HDLC_OVERFLOW  3   /*frame too long for the output stream, discarded*/
+
+/*receiver state, kept across calls so frames may span input buffers*/
+typedef struct tagT_HdlcDecoder {
+    unsigned short hunt;      /*1 while searching for an opening flag*/
+    unsigned short ones;      /*consecutive one bits received*/
+    unsigned short framebits; /*data bits taken for the current frame*/
+    unsigned short spill;     /*of those, bits past the end of the output stream*/
+} T_HdlcDecoder;
+
+/*
+ * Bits are processed in the order of the bit streams, so MSB-first and
+ * LSB-first streams are both supported. Stuffing and destuffing work a
+ * byte of input per table lookup and fall back to single bits only
+ * around flags.
+ */
+unsigned short hdlc_stuff(T_InputBitStream *in, unsigned short n, T_OutputBitStream *out);
+unsigned short hdlc_encodeframe(T_InputBitStream *in, unsigned short n, T_OutputBitStream *out);
+
+void hdlc_decoderinit(T_HdlcDecoder *dec);
+unsigned short hdlc_decodeframe(T_HdlcDecoder *dec, T_InputBitStream *in, T_OutputBitStream *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,86 @@
+#ifndef INGEST_H
+#define INGEST_H
+
+#include "codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*results besides CODEC_OK*/
+#define INGEST_NOMEM    16    /*buffer pool allocation failed*/
+#define INGEST_IOERROR  17    /*a read failed, ingest->oserror holds the errno*/
+#define INGEST_ALLHELD  18    /*every slot is held by the caller, nothing can be read until one is released*/
+
+/*ingest_init flags*/
+#define INGEST_BLOCKING  1    /*skip io_uring and use read() on the caller's thread*/
+
+#define INGEST_MAXSLOTS  1024
+
+/*
+ * Reads a file or a socket into a fixed pool of MAX_CODEC_BUFFER_LEN
+ * slots and hands every completed read out as an input stream over its
+ * slot, without copying. Reads run on an io_uring while the caller
+ * decodes earlier slots: a file or pipe is read with READ_FIXED into the
+ * registered pool, a socket with chains of linked RECVs. When io_uring is
+ * unavailable the same calls fall back to blocking reads.
+ *
+ * A regular file is read in readlen chunks at increasing offsets with up
+ * to slots reads in flight, and chunks are handed out in file order. For
+ * sockets and pipes each read is one message (one datagram or packet on
+ * SOCK_SEQPACKET), handed out in the order the socket delivered them. On
+ * a socket every free slot is queued as one chain of linked reads, which
+ * the kernel runs one after another, and the next chain starts once that
+ * one has completed; a pipe has one read in flight at a time.
+ */
+typedef struct tagT_Ingest {
+    int fd;
+    int stream;                   /*not a regular file: no offsets, reads start when none are in flight*/
+    int socket;                   /*a stream whose reads are queued as a chain of linked RECVs*/
+    unsigned short readlen;
+    unsigned int slots;           /*power of two*/
+    unsigned char *pool;          /*slots * MAX_CODEC_BUFFER_LEN bytes*/
+    int *results;                 /*bytes read into each slot, or -errno*/
+    unsigned char *states;
+    unsigned int *freelist;
+    unsigned int nfree;
+    unsigned int *order;          /*slot of each read in flight, by sequence number*/
+    unsigned long long submitted; /*sequence number of the next read*/
+    unsigned long long delivered; /*sequence number of the next read to hand out*/
+    unsigned long long offset;    /*file offset of the next read*/
+    unsigned int inflight;
+    int eof;
+    int oserror;
+    int held;                     /*the last ingest_next found every slot held*/
+    /*io_uring queues, fd -1 in blocking mode*/
+    int ring;
+    void *sqmap, *cqmap, *sqes;
+    unsigned long sqmapsize, cqmapsize, sqessize;
+    unsigned int *sqhead, *sqtail, *sqmask, *sqarray;
+    unsigned int *cqhead, *cqtail, *cqmask;
+    void *cqes;
+    unsigned int pending;         /*sqes queued but not yet submitted*/
+} T_Ingest;
+
+/*slots is rounded up to a power of two, readlen is at most MAX_CODEC_BUFFER_LEN*/
+unsigned short ingest_init(T_Ingest *ig, int fd, unsigned int slots, unsigned short readlen, unsigned int flags);
+void ingest_free(T_Ingest *ig);
+
+/*
+ * Waits for at least one completed read and fills up to max streams with
+ * slot ids in ids. Returns the number filled, or 0 when it cannot: at end
+ * of input, on a read error, or when every slot is still held by the
+ * caller and nothing can be read into. ingest_geterror tells which, giving
+ * CODEC_OK at end of input, INGEST_IOERROR or INGEST_ALLHELD. Only the
+ * last is not final: release some ids and call again. Each id must be
+ * given back with ingest_release once its stream is decoded.
+ */
+unsigned int ingest_next(T_Ingest *ig, T_InputByteStream *in, unsigned int *ids, unsigned int max);
+void ingest_release(T_Ingest *ig, unsigned int id);
+unsigned short ingest_geterror(T_Ingest *ig);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
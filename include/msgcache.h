@@ -0,0 +1,69 @@
+#ifndef MSGCACHE_H
+#define MSGCACHE_H
+
+#include <pthread.h>
+#include "codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MSGCACHE_WAYS   8      /*slots probed per lookup, CLOCK runs over these*/
+
+/*msgcache_init result besides CODEC_OK*/
+#define MSGCACHE_NOMEM  16
+
+/*
+ * Decodes one message from msg into value, returns CODEC_OK or the
+ * stream error. Only successful decodes are cached.
+ */
+typedef unsigned short (*T_MsgCacheDecode)(void *ctx, T_InputByteStream *msg, void *value);
+
+typedef struct tagT_MsgCacheStats {
+    unsigned long long hits;
+    unsigned long long misses;
+    unsigned long long evictions;
+    unsigned long long bypassed;    /*too long to cache or failed to decode*/
+} T_MsgCacheStats;
+
+/*one rwlock per shard, readers only touch the reference bits*/
+typedef struct tagT_MsgCacheShard {
+    pthread_rwlock_t lock;
+    unsigned int *hashes;
+    unsigned short *lens;           /*0 for an empty slot*/
+    unsigned char *refs;            /*CLOCK reference bits*/
+    unsigned char *raw;             /*maxlen bytes per slot, compared on a hash match*/
+    unsigned char *values;          /*valuesize bytes per slot*/
+    unsigned int hand;
+    T_MsgCacheStats stats;
+} T_MsgCacheShard;
+
+typedef struct tagT_MsgCache {
+    T_MsgCacheShard *shards;
+    unsigned int nshards;           /*power of two*/
+    unsigned int slots;             /*per shard, multiple of MSGCACHE_WAYS*/
+    unsigned short maxlen;
+    unsigned int valuesize;
+    T_MsgCacheDecode decode;
+    void *ctx;
+} T_MsgCache;
+
+/*
+ * Memoizes decode() on the raw message bytes. A CRC32C of the message
+ * picks the shard and the probe window; hits are confirmed against the
+ * stored bytes, so a collision only costs a decode. Messages longer than
+ * maxlen are always decoded.
+ */
+unsigned short msgcache_init(T_MsgCache *cache, unsigned int nshards, unsigned int slots,
+                             unsigned short maxlen, unsigned int valuesize,
+                             T_MsgCacheDecode decode, void *ctx);
+void msgcache_free(T_MsgCache *cache);
+unsigned short msgcache_decode(T_MsgCache *cache, unsigned char *msg, unsigned short len, void *value);
+void msgcache_getstats(T_MsgCache *cache, T_MsgCacheStats *stats);
+unsigned int msgcache_hash(const unsigned char *msg, unsigned short len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
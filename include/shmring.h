@@ -0,0 +1,78 @@
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include <stddef.h>
+#include "codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*results besides CODEC_OK*/
+#define SHMRING_NOMEM   16    /*memfd, ftruncate or mmap failed, see errno*/
+#define SHMRING_BADRING 17    /*fd does not hold a ring of this layout*/
+#define SHMRING_EMPTY   18    /*nothing published, non-blocking acquire*/
+#define SHMRING_FULL    19    /*no free slot, non-blocking reserve*/
+
+#define SHMRING_MAGIC   0x53484d52    /*"SHMR"*/
+
+/*
+ * Control block at the start of the mapping. head and tail are free-running
+ * slot counters and double as futex words; each sits on its own cache line
+ * with the flag its waiter raises before sleeping, so the other side only
+ * makes the wake syscall when somebody is actually asleep.
+ */
+typedef struct tagT_ShmRingControl {
+    unsigned int magic;
+    unsigned int slots;           /*power of two*/
+    unsigned int slotsize;        /*bytes of payload per slot*/
+    unsigned int stride;          /*slotsize rounded up to a cache line*/
+    unsigned char pad0[48];
+    unsigned int head;            /*slots published, written by the producer*/
+    unsigned int consumerwaits;
+    unsigned char pad1[56];
+    unsigned int tail;            /*slots released, written by the consumer*/
+    unsigned int producerwaits;
+    unsigned char pad2[56];
+} T_ShmRingControl;
+
+/*one end of a ring, local to the process that mapped it*/
+typedef struct tagT_ShmRing {
+    int fd;
+    size_t size;
+    T_ShmRingControl *ctl;
+    unsigned short *lens;         /*bytes published in each slot*/
+    unsigned char *data;
+    unsigned int slots;           /*copies of the control block, checked once at open*/
+    unsigned int stride;
+    unsigned short slotsize;
+    unsigned int limit;           /*cached bound from the other side's counter*/
+} T_ShmRing;
+
+/*
+ * Single-producer single-consumer ring of fixed-size slots in a memfd,
+ * shared by fork or by passing ring->fd over a unix socket. The producer
+ * reserves a slot as an output stream, encodes straight into it and
+ * publishes the length; the consumer acquires the slot as an input stream
+ * over the same pages and releases it when done. Payload bytes are never
+ * copied. slotsize is at most MAX_CODEC_BUFFER_LEN.
+ */
+unsigned short shmring_create(T_ShmRing *ring, unsigned int slots, unsigned short slotsize);
+unsigned short shmring_open(T_ShmRing *ring, int fd);
+void shmring_close(T_ShmRing *ring);
+
+/*producer; with wait set a full ring blocks instead of returning SHMRING_FULL*/
+unsigned short shmring_reserve(T_ShmRing *ring, T_OutputByteStream *out, int wait);
+unsigned short shmring_reservebits(T_ShmRing *ring, T_OutputBitStream *out, int wait);
+void shmring_publish(T_ShmRing *ring, unsigned short len);
+
+/*consumer; with wait set an empty ring blocks instead of returning SHMRING_EMPTY*/
+unsigned short shmring_acquire(T_ShmRing *ring, T_InputByteStream *in, int wait);
+unsigned short shmring_acquirebits(T_ShmRing *ring, T_InputBitStream *in, int wait);
+void shmring_release(T_ShmRing *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef TEXT_H
+#define TEXT_H
+
+#include "codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*results besides CODEC_OK and CODEC_SETTOOBITS*/
+#define TEXT_BADCHAR    16    /*a character outside the alphabet, or '=' before the end*/
+#define TEXT_BADLENGTH  17    /*hex of odd length, base64 not a multiple of 4*/
+
+/*characters written for n bytes*/
+#define TEXT_HEXLEN(n)  (2 * (n))
+#define TEXT_B64LEN(n)  (((n) + 2) / 3 * 4)
+
+/*
+ * Hex (lowercase out, either case in) and padded base64 with the standard
+ * alphabet, between bytes in memory, typically obytes_getbuf, and text
+ * appended to an output byte stream, or the other way round. Decoding
+ * checks every character before it writes any, with no whitespace
+ * allowed.
+ *
+ * Nothing is written unless the whole result fits and, when decoding,
+ * the whole input is valid; on failure the stream position and the
+ * buffer past it are unchanged, and only a result that does not fit sets
+ * the stream error. Counting streams are advanced, with decoding still
+ * checking the input.
+ *
+ * Hex runs 16 bytes at a time with SSE2, base64 with SSSE3 when the CPU
+ * has it, and both have a portable scalar path giving the same results.
+ */
+unsigned short text_hexencode(const unsigned char *src, unsigned short n, T_OutputByteStream *out);
+unsigned short text_hexdecode(const char *src, unsigned int n, T_OutputByteStream *out);
+unsigned short text_b64encode(const unsigned char *src, unsigned short n, T_OutputByteStream *out);
+unsigned short text_b64decode(const char *src, unsigned int n, T_OutputByteStream *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
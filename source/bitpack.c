@@ -0,0 +1,506 @@
+#include <string.h>
+#include "bitpack.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#define BITPACK_MASK(b)  ((b) ? 0xFFFFFFFFu >> (32 - (b)) : 0)
+
+static unsigned int bitpack_width(unsigned int value)
+{
+#if defined(__GNUC__)
+    return value ? 32 - __builtin_clz(value) : 0;
+#else
+    unsigned int w = 0;
+
+    for(; value; value >>= 1)
+        w ++;
+    return w;
+#endif
+}
+
+#if !defined(__SSE2__)
+static void bitpack_store(unsigned char *p, unsigned int v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static unsigned int bitpack_load(const unsigned char *p)
+{
+    return p[0] | p[1] << 8 | p[2] << 16 | (unsigned int)p[3] << 24;
+}
+#endif
+
+/*compilers merge this into one load on little-endian hosts*/
+static unsigned long long bitpack_load64(const unsigned char *p)
+{
+    return (unsigned long long)p[0] | (unsigned long long)p[1] << 8 | (unsigned long long)p[2] << 16
+         | (unsigned long long)p[3] << 24 | (unsigned long long)p[4] << 32 | (unsigned long long)p[5] << 40
+         | (unsigned long long)p[6] << 48 | (unsigned long long)p[7] << 56;
+}
+
+/*low b bits of 128 values into 16 * b bytes, four lanes of 32-bit words*/
+static void bitpack_pack(const unsigned int *in, unsigned char *out, unsigned int b)
+{
+    unsigned int j, shift = 0;
+#if defined(__SSE2__)
+    __m128i mask = _mm_set1_epi32((int)BITPACK_MASK(b)), acc = _mm_setzero_si128(), v;
+
+    for(j = 0; j < BITPACK_BLOCK / 4; j++)
+    {
+        v = _mm_and_si128(_mm_loadu_si128((const __m128i *)(in + 4 * j)), mask);
+        acc = _mm_or_si128(acc, _mm_sll_epi32(v, _mm_cvtsi32_si128((int)shift)));
+        shift += b;
+        if(shift >= 32)
+        {
+            _mm_storeu_si128((__m128i *)out, acc);
+            out += 16;
+            shift -= 32;
+            acc = _mm_srl_epi32(v, _mm_cvtsi32_si128((int)(b - shift)));
+        }
+    }
+#else
+    unsigned int lane, word, acc, v, mask = BITPACK_MASK(b);
+
+    for(lane = 0; lane < 4; lane++)
+    {
+        for(j = 0, word = 0, acc = 0, shift = 0; j < BITPACK_BLOCK / 4; j++)
+        {
+            v = in[4 * j + lane] & mask;
+            acc |= v << shift;
+            shift += b;
+            if(shift >= 32)
+            {
+                bitpack_store(out + 16 * word++ + 4 * lane, acc);
+                shift -= 32;
+                acc = shift ? v >> (b - shift) : 0;
+            }
+        }
+    }
+#endif
+}
+
+/*
+ * Inverse of bitpack_pack for one width, adding base to every value and
+ * with delta set keeping the running sum from prev, which it returns.
+ * Always inlined into the switch below with b and delta constant, so the
+ * loop unrolls into fixed shifts and loads: a shift by a run-time count
+ * would cost a dependent move per row. Restoring the values here, while
+ * they are in registers, saves a second pass over the block.
+ */
+#if defined(__GNUC__)
+#define BITPACK_KERNEL static CODEC_INLINE __attribute__((always_inline))
+#else
+#define BITPACK_KERNEL static CODEC_INLINE
+#endif
+
+BITPACK_KERNEL unsigned int bitpack_unpackwidth(const unsigned char *in, unsigned int *out, const unsigned int b,
+                                                unsigned int base, unsigned int prev, const int delta)
+{
+    unsigned int j, shift = 0;
+#if defined(__SSE2__)
+    const __m128i mask = _mm_set1_epi32((int)BITPACK_MASK(b)), vbase = _mm_set1_epi32((int)base);
+    __m128i cur, v, vprev = _mm_set1_epi32((int)prev);
+
+    cur = _mm_loadu_si128((const __m128i *)in);
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC unroll 32
+#endif
+    for(j = 0; j < BITPACK_BLOCK / 4; j++)
+    {
+        v = _mm_srli_epi32(cur, shift);
+        shift += b;
+        if(shift >= 32)
+        {
+            shift -= 32;
+            if(j + 1 < BITPACK_BLOCK / 4)
+            {
+                in += 16;
+                cur = _mm_loadu_si128((const __m128i *)in);
+            }
+            if(shift)
+                v = _mm_or_si128(v, _mm_slli_epi32(cur, b - shift));
+        }
+        v = _mm_add_epi32(_mm_and_si128(v, mask), vbase);
+        if(delta)
+        {
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+            v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+            v = _mm_add_epi32(v, vprev);
+            vprev = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+        }
+        _mm_storeu_si128((__m128i *)(out + 4 * j), v);
+    }
+
+    return (unsigned int)_mm_cvtsi128_si32(vprev);
+#else
+    unsigned int lane, word, cur, v, mask = BITPACK_MASK(b);
+
+    for(lane = 0; lane < 4; lane++)
+    {
+        cur = bitpack_load(in + 4 * lane);
+        for(j = 0, word = 0, shift = 0; j < BITPACK_BLOCK / 4; j++)
+        {
+            v = cur >> shift;
+            shift += b;
+            if(shift >= 32)
+            {
+                shift -= 32;
+                if(j + 1 < BITPACK_BLOCK / 4)
+                    cur = bitpack_load(in + 16 * ++word + 4 * lane);
+                if(shift)
+                    v |= cur << (b - shift);
+            }
+            out[4 * j + lane] = (v & mask) + base;
+        }
+    }
+
+    for(j = 0; delta && j < BITPACK_BLOCK; j++)
+        out[j] = prev += out[j];
+    return prev;
+#endif
+}
+
+#define BITPACK_CASE(b)  case b: return delta ? bitpack_unpackwidth(in, out, b, base, prev, 1) \
+                                              : bitpack_unpackwidth(in, out, b, base, prev, 0);
+
+/*b from 1 to 32, returns the running sum with delta set*/
+static unsigned int bitpack_unpack(const unsigned char *in, unsigned int *out, unsigned int b,
+                                   unsigned int base, unsigned int prev, int delta)
+{
+    switch(b)
+    {
+    BITPACK_CASE(1)  BITPACK_CASE(2)  BITPACK_CASE(3)  BITPACK_CASE(4)
+    BITPACK_CASE(5)  BITPACK_CASE(6)  BITPACK_CASE(7)  BITPACK_CASE(8)
+    BITPACK_CASE(9)  BITPACK_CASE(10) BITPACK_CASE(11) BITPACK_CASE(12)
+    BITPACK_CASE(13) BITPACK_CASE(14) BITPACK_CASE(15) BITPACK_CASE(16)
+    BITPACK_CASE(17) BITPACK_CASE(18) BITPACK_CASE(19) BITPACK_CASE(20)
+    BITPACK_CASE(21) BITPACK_CASE(22) BITPACK_CASE(23) BITPACK_CASE(24)
+    BITPACK_CASE(25) BITPACK_CASE(26) BITPACK_CASE(27) BITPACK_CASE(28)
+    BITPACK_CASE(29) BITPACK_CASE(30) BITPACK_CASE(31) BITPACK_CASE(32)
+    }
+
+    return prev;
+}
+
+/*fewer than BITPACK_BLOCK values as one little-endian bit string, (n * b + 7) / 8 bytes*/
+static void bitpack_packtail(const unsigned int *in, unsigned int n, unsigned char *out, unsigned int b)
+{
+    unsigned long long acc = 0;
+    unsigned int i, have = 0, mask = BITPACK_MASK(b);
+
+    for(i = 0; i < n; i++)
+    {
+        acc |= (unsigned long long)(in[i] & mask) << have;
+        for(have += b; have >= 8; have -= 8, acc >>= 8)
+            *out++ = (unsigned char)acc;
+    }
+    if(have)
+        *out = (unsigned char)acc;
+}
+
+/*avail is the input left from in, so the eight byte loads stay inside it; base is added to every value*/
+static void bitpack_unpacktail(const unsigned char *in, unsigned int avail, unsigned int n, unsigned int *out,
+                               unsigned int b, unsigned int base)
+{
+    unsigned long long w;
+    unsigned int i, k, pos, mask = BITPACK_MASK(b);
+
+    /*once a load runs past the end every later one does*/
+    for(i = 0, pos = 0; i < n && (pos >> 3) + 8 <= avail; i++, pos += b)
+        out[i] = ((unsigned int)(bitpack_load64(in + (pos >> 3)) >> (pos & 7)) & mask) + base;
+
+    for(; i < n; i++, pos += b)
+    {
+        for(w = 0, k = 0; (pos >> 3) + k < avail; k++)
+            w |= (unsigned long long)in[(pos >> 3) + k] << 8 * k;
+        out[i] = ((unsigned int)(w >> (pos & 7)) & mask) + base;
+    }
+}
+
+/*width and exception count giving the fewest bits, exceptions carry maxwidth - width bits*/
+static unsigned int bitpack_choose(const unsigned int *r, unsigned int n, unsigned int *exceptions, unsigned int *maxwidth)
+{
+    unsigned int count[33] = {0}, i, b, above = 0, cost, best, width;
+
+    for(i = 0; i < n; i++)
+        count[bitpack_width(r[i])] ++;
+    for(width = 32; width > 0 && count[width] == 0; width--)
+        ;
+
+    *maxwidth = width;
+    *exceptions = 0;
+    best = n * width;
+    for(b = *maxwidth; b-- > 0; )
+    {
+        above += count[b + 1];
+        cost = n * b + 6 + above * (7 + *maxwidth - b);
+        if(cost < best)
+        {
+            best = cost;
+            width = b;
+            *exceptions = above;
+        }
+    }
+
+    return width;
+}
+
+static void bitpack_putblock(T_OutputBitStream *out, const unsigned int *r, unsigned int n, unsigned int base)
+{
+    T_BitStream *o = &out->bits;
+    unsigned int b, exceptions, maxwidth, i, mask, bytes;
+
+    b = bitpack_choose(r, n, &exceptions, &maxwidth);
+    mask = BITPACK_MASK(b);
+
+    obits_setbit(out, 6, b);
+    obits_setbit(out, 8, exceptions);
+    if(exceptions)
+        obits_setbit(out, 6, maxwidth - b);
+    obits_setdword(out, base);
+
+    if(b > 0)
+    {
+        bytes = n == BITPACK_BLOCK ? 16 * b : (n * b + 7) / 8;
+        if(o->curbit & 7)
+            obits_setbit(out, 8 - (o->curbit & 7), 0);
+        if(o->error != CODEC_OK)
+            return;
+        if(o->curbyte + bytes > o->totallen)
+        {
+            o->error = CODEC_SETTOOBITS;
+            return;
+        }
+
+        if(o->buffer == NULL)
+            ;    /*counting stream*/
+        else if(n == BITPACK_BLOCK)
+            bitpack_pack(r, &o->buffer[o->curbyte], b);
+        else
+            bitpack_packtail(r, n, &o->buffer[o->curbyte], b);
+        o->curbit += 8 * bytes;
+        o->curbyte = o->curbit >> 3;
+    }
+
+    for(i = 0; exceptions && i < n; i++)
+    {
+        if(r[i] > mask)
+        {
+            obits_setbit(out, 7, i);
+            obits_setbit(out, maxwidth - b, r[i] >> b);
+        }
+    }
+}
+
+unsigned short bitpack_encode(T_OutputBitStream *out, const unsigned int *values, unsigned int n, unsigned int mode)
+{
+    unsigned int r[BITPACK_BLOCK], i, j, k, base, prev;
+
+    if(n > BITPACK_MAXVALUES)
+        return BITPACK_TOOMANY;
+    if(mode != BITPACK_FOR && mode != BITPACK_DELTA)
+        return BITPACK_CORRUPT;
+
+    obits_setbit(out, 2, mode);
+    obits_setbit(out, 16, n);
+    prev = n ? values[0] : 0;
+    if(mode == BITPACK_DELTA && n > 0)
+        obits_setdword(out, prev);
+
+    for(i = 0; i < n && out->bits.error == CODEC_OK; i += k)
+    {
+        k = n - i < BITPACK_BLOCK ? n - i : BITPACK_BLOCK;
+
+        if(mode == BITPACK_FOR)
+        {
+            for(j = 0, base = values[i]; j < k; j++)
+                base = values[i + j] < base ? values[i + j] : base;
+            for(j = 0; j < k; j++)
+                r[j] = values[i + j] - base;
+        }
+        else
+        {
+            /*differences wrap, the smallest as signed is the base*/
+            for(j = 0; j < k; j++)
+            {
+                r[j] = values[i + j] - prev;
+                prev = values[i + j];
+            }
+            for(j = 0, base = r[0]; j < k; j++)
+                base = (int)r[j] < (int)base ? r[j] : base;
+            for(j = 0; j < k; j++)
+                r[j] -= base;
+        }
+
+        bitpack_putblock(out, r, k, base);
+    }
+
+    return out->bits.error;
+}
+
+/*the running sum of values from prev, for DELTA blocks the kernel could not sum*/
+static unsigned int bitpack_runsum(unsigned int *values, unsigned int n, unsigned int prev)
+{
+    unsigned int i = 0;
+#if defined(__SSE2__)
+    __m128i vprev = _mm_set1_epi32((int)prev), x;
+
+    for(; i + 4 <= n; i += 4)
+    {
+        x = _mm_loadu_si128((const __m128i *)(values + i));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 4));
+        x = _mm_add_epi32(x, _mm_slli_si128(x, 8));
+        x = _mm_add_epi32(x, vprev);
+        vprev = _mm_shuffle_epi32(x, _MM_SHUFFLE(3, 3, 3, 3));
+        _mm_storeu_si128((__m128i *)(values + i), x);
+    }
+    prev = (unsigned int)_mm_cvtsi128_si32(vprev);
+#endif
+
+    for(; i < n; i++)
+        values[i] = prev += values[i];
+
+    return prev;
+}
+
+/*values[from] on all raised by add, for an exception found after the DELTA sum*/
+static void bitpack_addfrom(unsigned int *values, unsigned int from, unsigned int n, unsigned int add)
+{
+#if defined(__SSE2__)
+    __m128i vadd = _mm_set1_epi32((int)add);
+
+    for(; from + 4 <= n; from += 4)
+        _mm_storeu_si128((__m128i *)(values + from), _mm_add_epi32(_mm_loadu_si128((const __m128i *)(values + from)), vadd));
+#endif
+
+    for(; from < n; from++)
+        values[from] += add;
+}
+
+/*two fields written back to back, read with one call when they fit in 32 bits*/
+static void bitpack_getpair(T_InputBitStream *in, unsigned int n1, unsigned int n2, unsigned int *v1, unsigned int *v2)
+{
+    unsigned int v;
+
+    if(n1 + n2 > 32)
+    {
+        *v1 = ibits_getbit(in, n1);
+        *v2 = ibits_getbit(in, n2);
+        return;
+    }
+
+    v = ibits_getbit(in, n1 + n2);
+    if(in->bits.order == CODEC_MSB_FIRST)
+    {
+        *v1 = v >> n2;
+        *v2 = v & BITPACK_MASK(n2);
+    }
+    else
+    {
+        *v1 = v & BITPACK_MASK(n1);
+        *v2 = v >> n1;
+    }
+}
+
+/*
+ * Decodes one block into values, restored from the base and in DELTA mode
+ * from *prev, which is moved on to the last value. A full DELTA block with
+ * up to BITPACK_FIXUPS exceptions is summed inside the kernel and each
+ * exception then raises the values from its position on; with more, they
+ * are added in first and the sum takes a pass of its own.
+ */
+#define BITPACK_FIXUPS  4
+
+static unsigned short bitpack_getblock(T_InputBitStream *in, unsigned int *values, unsigned int n, unsigned int mode, unsigned int *prev)
+{
+    T_BitStream *i = &in->bits;
+    unsigned int b, exceptions, extra = 0, k, pos, high, bytes, base, summed = 0;
+
+    bitpack_getpair(in, 6, 8, &b, &exceptions);
+    if(exceptions)
+        extra = ibits_getbit(in, 6);
+    base = ibits_getdword(in);
+    if(i->error != CODEC_OK)
+        return i->error;
+    if(b > 32 || exceptions > n || (exceptions && (extra < 1 || b + extra > 32)))
+        return BITPACK_CORRUPT;
+
+    if(b == 0)
+    {
+        for(k = 0; k < n; k++)
+            values[k] = base;
+    }
+    else
+    {
+        /*moved here rather than with ibits_forward, which refuses to reach the end*/
+        bytes = n == BITPACK_BLOCK ? 16 * b : (n * b + 7) / 8;
+        pos = (i->curbit + 7u) & ~7u;
+        if(pos + 8 * bytes > 8u * i->totallen)
+        {
+            i->error = CODEC_GETTOOBITS;
+            return i->error;
+        }
+
+        k = pos >> 3;
+        i->curbit = (unsigned short)(pos + 8 * bytes);
+        i->curbyte = i->curbit >> 3;
+        summed = n == BITPACK_BLOCK && mode == BITPACK_DELTA && exceptions <= BITPACK_FIXUPS;
+        if(summed)
+            *prev = bitpack_unpack(&i->buffer[k], values, b, base, *prev, 1);
+        else if(n == BITPACK_BLOCK)
+            bitpack_unpack(&i->buffer[k], values, b, base, 0, 0);
+        else
+            bitpack_unpacktail(&i->buffer[k], i->totallen - k, n, values, b, base);
+    }
+
+    /*the low bits are below 1 << b, so adding the high bits after the base sets them*/
+    for(k = 0; k < exceptions; k++)
+    {
+        bitpack_getpair(in, 7, extra, &pos, &high);
+        if(pos >= n)
+            return i->error != CODEC_OK ? i->error : BITPACK_CORRUPT;
+        if(summed)
+            bitpack_addfrom(values, pos, n, high << b);
+        else
+            values[pos] += high << b;
+    }
+
+    if(summed)
+        *prev = values[n - 1];
+    else if(mode == BITPACK_DELTA)
+        *prev = bitpack_runsum(values, n, *prev);
+    return i->error;
+}
+
+unsigned short bitpack_decode(T_InputBitStream *in, unsigned int *values, unsigned int max, unsigned int *n)
+{
+    unsigned int mode, count, prev = 0, i, k;
+    unsigned short r;
+
+    *n = 0;
+    mode = ibits_getbit(in, 2);
+    count = ibits_getbit(in, 16);
+    if(mode == BITPACK_DELTA && count > 0)
+        prev = ibits_getdword(in);
+    if(in->bits.error != CODEC_OK)
+        return in->bits.error;
+    if(mode != BITPACK_FOR && mode != BITPACK_DELTA)
+        return BITPACK_CORRUPT;
+    if(count > max)
+        return BITPACK_TOOMANY;
+
+    for(i = 0; i < count; i += k)
+    {
+        k = count - i < BITPACK_BLOCK ? count - i : BITPACK_BLOCK;
+        if((r = bitpack_getblock(in, values + i, k, mode, &prev)) != CODEC_OK)
+            return r;
+    }
+
+    *n = count;
+    return CODEC_OK;
+}
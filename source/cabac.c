@@ -0,0 +1,291 @@
+#include <stddef.h>
+#include "cabac.h"
+
+/*LPS range by probability state and quantized range, H.264 table 9-44*/
+static const unsigned char rangelps[64][4] = {
+    {128, 176, 208, 240}, {128, 167, 197, 227}, {128, 158, 187, 216}, {123, 150, 178, 205},
+    {116, 142, 169, 195}, {111, 135, 160, 185}, {105, 128, 152, 175}, {100, 122, 144, 166},
+    { 95, 116, 137, 158}, { 90, 110, 130, 150}, { 85, 104, 123, 142}, { 81,  99, 117, 135},
+    { 77,  94, 111, 128}, { 73,  89, 105, 122}, { 69,  85, 100, 116}, { 66,  80,  95, 110},
+    { 62,  76,  90, 104}, { 59,  72,  86,  99}, { 56,  69,  81,  94}, { 53,  65,  77,  89},
+    { 51,  62,  73,  85}, { 48,  59,  69,  80}, { 46,  56,  66,  76}, { 43,  53,  63,  72},
+    { 41,  50,  59,  69}, { 39,  48,  56,  65}, { 37,  45,  54,  62}, { 35,  43,  51,  59},
+    { 33,  41,  48,  56}, { 32,  39,  46,  53}, { 30,  37,  43,  50}, { 29,  35,  41,  48},
+    { 27,  33,  39,  45}, { 26,  31,  37,  43}, { 24,  30,  35,  41}, { 23,  28,  33,  39},
+    { 22,  27,  32,  37}, { 21,  26,  30,  35}, { 20,  24,  29,  33}, { 19,  23,  27,  31},
+    { 18,  22,  26,  30}, { 17,  21,  25,  28}, { 16,  20,  23,  27}, { 15,  19,  22,  25},
+    { 14,  18,  21,  24}, { 14,  17,  20,  23}, { 13,  16,  19,  22}, { 12,  15,  18,  21},
+    { 12,  14,  17,  20}, { 11,  14,  16,  19}, { 11,  13,  15,  18}, { 10,  12,  15,  17},
+    { 10,  12,  14,  16}, {  9,  11,  13,  15}, {  9,  11,  12,  14}, {  8,  10,  12,  14},
+    {  8,   9,  11,  13}, {  7,   9,  11,  12}, {  7,   9,  10,  12}, {  7,   8,  10,  11},
+    {  6,   8,   9,  11}, {  6,   7,   9,  10}, {  6,   7,   8,   9}, {  2,   2,   2,   2}
+    };
+
+/*next state after an LPS, H.264 table 9-45*/
+static const unsigned char translps[64] = {
+     0,  0,  1,  2,  2,  4,  4,  5,  6,  7,  8,  9,  9, 11, 11, 12,
+    13, 13, 15, 15, 16, 16, 18, 18, 19, 19, 21, 21, 22, 22, 23, 24,
+    24, 25, 26, 26, 27, 27, 28, 29, 29, 30, 30, 30, 31, 32, 32, 33,
+    33, 33, 34, 34, 35, 35, 35, 36, 36, 36, 37, 37, 37, 38, 38, 63
+    };
+
+/*next state after an MPS*/
+static const unsigned char transmps[64] = {
+     1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15, 16,
+    17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32,
+    33, 34, 35, 36, 37, 38, 39, 40, 41, 42, 43, 44, 45, 46, 47, 48,
+    49, 50, 51, 52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 62, 62, 63
+    };
+
+/*shifts bringing range back to 256-510, indexed by range >> 3*/
+static const unsigned char renormshift[64] = {
+    6, 5, 4, 4, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2, 2, 2,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+    };
+
+/*encoder*/
+static void cabac_writebyte(T_OutputBitStream *bits, unsigned char byte)
+{
+    T_BitStream *b = &bits->bits;
+
+    if((b->curbit & 7) == 0 && b->curbyte < b->totallen)
+    {
+        if(b->buffer != NULL)
+            b->buffer[b->curbyte] = byte;
+        b->curbyte ++;
+        b->curbit += 8;
+        return;
+    }
+
+    obits_setbyte(bits, byte);
+}
+
+static void cabac_putbyte(T_CabacEncoder *enc)
+{
+    int out, carry;
+
+    if(enc->queue < 0)
+        return;
+
+    out = enc->low >> (enc->queue + 10);
+    enc->low &= (0x400 << enc->queue) - 1;
+    enc->queue -= 8;
+
+    /*a run of 0xff bytes is held back until a carry is ruled out*/
+    if((out & 0xff) == 0xff)
+    {
+        enc->outstanding ++;
+        return;
+    }
+
+    carry = out >> 8;
+    if(enc->cache >= 0)
+        cabac_writebyte(enc->bits, (unsigned char)(enc->cache + carry));
+
+    for(; enc->outstanding > 0; enc->outstanding --)
+        cabac_writebyte(enc->bits, (unsigned char)(0xff + carry));
+
+    enc->cache = out & 0xff;
+}
+
+static void cabac_encoderenorm(T_CabacEncoder *enc, unsigned char shift)
+{
+    enc->range <<= shift;
+    enc->low <<= shift;
+    enc->queue += shift;
+    cabac_putbyte(enc);
+}
+
+void cabac_encodeinit(T_CabacEncoder *enc, T_OutputBitStream *bits)
+{
+    enc->bits = bits;
+    enc->low = 0;
+    enc->range = 510;
+    enc->queue = -9;
+    enc->cache = -1;
+    enc->outstanding = 0;
+}
+
+void cabac_encodebin(T_CabacEncoder *enc, T_CabacContext *ctx, unsigned char bin)
+{
+    unsigned char state = *ctx >> 1;
+    unsigned char mps = *ctx & 1;
+    unsigned int lps = rangelps[state][(enc->range >> 6) & 3];
+
+    enc->range -= lps;
+    if(bin != mps)
+    {
+        enc->low += enc->range;
+        enc->range = lps;
+        *ctx = (translps[state] << 1) | (state == 0 ? !mps : mps);
+    }
+    else
+    {
+        *ctx = (transmps[state] << 1) | mps;
+    }
+
+    cabac_encoderenorm(enc, renormshift[enc->range >> 3]);
+}
+
+void cabac_encodebypass(T_CabacEncoder *enc, unsigned char bin)
+{
+    enc->low <<= 1;
+    if(bin)
+        enc->low += enc->range;
+    enc->queue += 1;
+    cabac_putbyte(enc);
+}
+
+void cabac_encodeterminate(T_CabacEncoder *enc, unsigned char bin)
+{
+    enc->range -= 2;
+    if(bin)
+    {
+        enc->low += enc->range;
+        enc->range = 2;
+        cabac_encoderenorm(enc, 7);
+        return;
+    }
+
+    cabac_encoderenorm(enc, renormshift[enc->range >> 3]);
+}
+
+/*write out every remaining bit of low, the decoder reads past the end as zeros*/
+void cabac_encodeflush(T_CabacEncoder *enc)
+{
+    int i;
+
+    for(i=0; i<3; i++)
+    {
+        enc->low <<= 8;
+        enc->queue += 8;
+        cabac_putbyte(enc);
+    }
+
+    if(enc->cache >= 0)
+        cabac_writebyte(enc->bits, (unsigned char)enc->cache);
+
+    for(; enc->outstanding > 0; enc->outstanding --)
+        cabac_writebyte(enc->bits, 0xff);
+
+    enc->low = 0;
+    enc->queue = -9;
+    enc->cache = -1;
+}
+
+/*decoder*/
+static unsigned char cabac_readbyte(T_InputBitStream *bits)
+{
+    T_BitStream *b = &bits->bits;
+    unsigned int left = 8 * b->totallen - b->curbit;
+
+    if((b->curbit & 7) == 0 && left >= 8)
+    {
+        b->curbit += 8;
+        return b->buffer[b->curbyte ++];
+    }
+
+    if(left >= 8)
+        return ibits_getbyte(bits);
+
+    if(left == 0)
+        return 0;
+
+    if(bits->bits.order == CODEC_LSB_FIRST)
+        return (unsigned char)ibits_getbit(bits, (unsigned char)left);
+
+    return (unsigned char)(ibits_getbit(bits, (unsigned char)left) << (8 - left));
+}
+
+/*keep at least 8 bits buffered below the offset, a whole byte per read*/
+static void cabac_refill(T_CabacDecoder *dec)
+{
+    while(dec->count < 8)
+    {
+        dec->value = (dec->value << 8) | cabac_readbyte(dec->bits);
+        dec->count += 8;
+    }
+}
+
+static void cabac_decoderenorm(T_CabacDecoder *dec, unsigned char shift)
+{
+    dec->range <<= shift;
+    dec->count -= shift;
+    if(dec->count < 8)
+        cabac_refill(dec);
+}
+
+void cabac_decodeinit(T_CabacDecoder *dec, T_InputBitStream *bits)
+{
+    dec->bits = bits;
+    dec->value = 0;
+    dec->range = 510;
+    dec->count = -9;
+    cabac_refill(dec);
+}
+
+unsigned char cabac_decodebin(T_CabacDecoder *dec, T_CabacContext *ctx)
+{
+    unsigned char state = *ctx >> 1;
+    unsigned char bin = *ctx & 1;
+    unsigned int lps = rangelps[state][(dec->range >> 6) & 3];
+    unsigned int scaled;
+
+    dec->range -= lps;
+    scaled = dec->range << dec->count;
+    if(dec->value < scaled)
+    {
+        *ctx = (transmps[state] << 1) | bin;
+        if(dec->range >= 256)
+            return bin;
+    }
+    else
+    {
+        dec->value -= scaled;
+        dec->range = lps;
+        *ctx = (translps[state] << 1) | (state == 0 ? !bin : bin);
+        bin = !bin;
+    }
+
+    cabac_decoderenorm(dec, renormshift[dec->range >> 3]);
+    return bin;
+}
+
+unsigned char cabac_decodebypass(T_CabacDecoder *dec)
+{
+    unsigned int scaled;
+    unsigned char bin = 0;
+
+    dec->count --;
+    scaled = dec->range << dec->count;
+    if(dec->value >= scaled)
+    {
+        dec->value -= scaled;
+        bin = 1;
+    }
+
+    if(dec->count < 8)
+        cabac_refill(dec);
+
+    return bin;
+}
+
+unsigned char cabac_decodeterminate(T_CabacDecoder *dec)
+{
+    unsigned int scaled;
+
+    dec->range -= 2;
+    scaled = dec->range << dec->count;
+    if(dec->value >= scaled)
+    {
+        dec->value -= scaled;
+        dec->range = 2;
+        cabac_decoderenorm(dec, 7);
+        return 1;
+    }
+
+    cabac_decoderenorm(dec, renormshift[dec->range >> 3]);
+    return 0;
+}
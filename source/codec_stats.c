@@ -0,0 +1,149 @@
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "codec_stats.h"
+
+#ifdef CODEC_STATS
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/*self of threads that have not initialized a stream yet, never counted into*/
+T_CodecStats codec_stats_shared;
+
+CODEC_STATS_TLS T_CodecStats *codec_stats_self = &codec_stats_shared;
+
+/*every block ever attached, pushed with a CAS and never removed*/
+static T_CodecStats *codec_stats_head = &codec_stats_shared;
+
+/*blocks outlive their thread so its counts stay in the totals*/
+T_CodecStats *codec_stats_attach(void)
+{
+    T_CodecStats *s = calloc(1, sizeof(*s));
+
+    if(s == NULL)
+        abort();
+
+    s->next = __atomic_load_n(&codec_stats_head, __ATOMIC_RELAXED);
+    while(!__atomic_compare_exchange_n(&codec_stats_head, &s->next, s, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+
+    codec_stats_self = s;
+    return s;
+}
+
+unsigned long long codec_stats_clock(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+#endif
+}
+
+/*closes a timed message*/
+void codec_stats_time(T_CodecStats *s)
+{
+    unsigned long long t = codec_stats_clock() - s->started;
+    unsigned int b = t ? 63 - __builtin_clzll(t) : 0;
+
+    s->latency[s->tag][b < CODEC_STATS_BUCKETS ? b : CODEC_STATS_BUCKETS - 1] ++;
+    s->cycles[s->tag] += t;
+    s->started = 0;
+}
+
+/*sum of all threads, each counter may be a few increments behind its writer and the others*/
+void codec_stats_snapshot(T_CodecStats *out)
+{
+    T_CodecStats *s;
+    unsigned int i, j;
+
+    memset(out, 0, sizeof(*out));
+    for(s = __atomic_load_n(&codec_stats_head, __ATOMIC_ACQUIRE); s != NULL; s = s->next)
+    {
+        for(i=0; i<CODEC_OPS; i++)
+        {
+            out->calls[i] += __atomic_load_n(&s->calls[i], __ATOMIC_RELAXED);
+            out->moved[i] += __atomic_load_n(&s->moved[i], __ATOMIC_RELAXED);
+        }
+
+        for(i=0; i<CODEC_STATS_ERRORS; i++)
+            out->errors[i] += __atomic_load_n(&s->errors[i], __ATOMIC_RELAXED);
+
+        for(i=0; i<CODEC_STATS_TAGS; i++)
+        {
+            out->messages[i] += __atomic_load_n(&s->messages[i], __ATOMIC_RELAXED);
+            for(j=0; j<CODEC_STATS_BUCKETS; j++)
+                out->latency[i][j] += __atomic_load_n(&s->latency[i][j], __ATOMIC_RELAXED);
+            out->cycles[i] += __atomic_load_n(&s->cycles[i], __ATOMIC_RELAXED);
+        }
+    }
+}
+
+/*bits moved by a move or a fixed-width byte call, 0 for the bit calls whose widths are not counted*/
+unsigned long long codec_stats_bits(const T_CodecStats *stats, unsigned int prim)
+{
+    switch(prim)
+    {
+    case CODEC_OP_IBYTES_FORWARD: case CODEC_OP_IBYTES_BACK:
+    case CODEC_OP_IBITS_FORWARD: case CODEC_OP_IBITS_BACK:
+        return stats->moved[prim];
+    case CODEC_OP_IBYTES_GETBYTE: case CODEC_OP_OBYTES_SETBYTE: case CODEC_OP_OBYTES_SETBYTEBYPOS:
+        return 8 * stats->calls[prim];
+    case CODEC_OP_IBYTES_GETWORD: case CODEC_OP_OBYTES_SETWORD: case CODEC_OP_OBYTES_SETWORDBYPOS:
+        return 16 * stats->calls[prim];
+    case CODEC_OP_IBYTES_GETDWORD: case CODEC_OP_OBYTES_SETDWORD: case CODEC_OP_OBYTES_SETDWORDBYPOS:
+        return 32 * stats->calls[prim];
+    }
+    return 0;
+}
+
+/*one line per non-zero counter, "kind key... value"*/
+void codec_stats_print(const T_CodecStats *stats, FILE *f)
+{
+    unsigned long long in = 0, out = 0, count;
+    unsigned int i, j;
+
+    for(i=0; i<CODEC_OPS; i++)
+    {
+        if(stats->calls[i])
+            fprintf(f, "calls %s %llu\n", codec_opname(i), stats->calls[i]);
+    }
+
+    /*rewinds are reported on their own, not taken off or added to the reads*/
+    for(i=CODEC_OP_IBYTES_GETBYTE; i<=CODEC_OP_IBYTES_FORWARD; i++)
+        in += codec_stats_bits(stats, i);
+    for(i=CODEC_OP_OBYTES_SETBYTE; i<=CODEC_OP_OBYTES_SETDWORDBYPOS; i++)
+        out += codec_stats_bits(stats, i);
+    fprintf(f, "bytes read %llu\nbytes written %llu\nbytes back %llu\n", in / 8, out / 8,
+            codec_stats_bits(stats, CODEC_OP_IBYTES_BACK) / 8);
+
+    /*bit reads and writes have only their calls counted*/
+    fprintf(f, "bits forward %llu\nbits back %llu\n", codec_stats_bits(stats, CODEC_OP_IBITS_FORWARD),
+            codec_stats_bits(stats, CODEC_OP_IBITS_BACK));
+
+    for(i=1; i<CODEC_STATS_ERRORS; i++)
+    {
+        if(stats->errors[i])
+            fprintf(f, "errors %u %llu\n", i, stats->errors[i]);
+    }
+
+    for(i=0; i<CODEC_STATS_TAGS; i++)
+    {
+        if(stats->messages[i])
+            fprintf(f, "messages %u %llu\n", i, stats->messages[i]);
+        for(j=0, count=0; j<CODEC_STATS_BUCKETS; j++)
+        {
+            count += stats->latency[i][j];
+            if(stats->latency[i][j])
+                fprintf(f, "latency %u %llu %llu\n", i, 1ULL << j, stats->latency[i][j]);
+        }
+        if(count)
+            fprintf(f, "cycles %u %llu\n", i, stats->cycles[i] / count);
+    }
+}
+
+#endif
@@ -0,0 +1,83 @@
+#include <stdlib.h>
+#include <string.h>
+#include "codec_trace.h"
+
+#ifdef CODEC_TRACE
+
+/*ring of threads that have not initialized a stream yet, size 0 so it drops everything*/
+T_TraceRing codec_trace_none;
+
+CODEC_TRACE_TLS T_TraceRing *codec_trace_self = &codec_trace_none;
+
+/*every ring ever attached, pushed with a CAS and never removed*/
+static T_TraceRing *codec_trace_head;
+static unsigned int codec_trace_threads;
+
+/*rings outlive their thread so its last events can still be dumped*/
+T_TraceRing *codec_trace_attach(void)
+{
+    T_TraceRing *r = calloc(1, sizeof(*r));
+
+    if(r == NULL || (r->events = malloc(CODEC_TRACE_EVENTS * sizeof(T_TraceEvent))) == NULL)
+        abort();
+
+    r->size = CODEC_TRACE_EVENTS;
+    r->limit = r->size;
+    r->thread = __atomic_fetch_add(&codec_trace_threads, 1, __ATOMIC_RELAXED);
+
+    r->next = __atomic_load_n(&codec_trace_head, __ATOMIC_RELAXED);
+    while(!__atomic_compare_exchange_n(&codec_trace_head, &r->next, r, 1, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        ;
+
+    codec_trace_self = r;
+    return r;
+}
+
+/*
+ * Write a header, then every event recorded since the last dump, one block
+ * per thread with events. Each call makes a complete trace on its own, and
+ * calls appended to one file still read as one. Only one thread may dump
+ * at a time, the producers keep running. Returns the number of events
+ * written, or -1 on a write error.
+ */
+int codec_trace_dump(FILE *f)
+{
+    T_TraceRing *r;
+    T_TraceBlock block;
+    unsigned int head, tail, first, words[2];
+    int total = 0;
+
+    words[0] = CODEC_TRACE_VERSION;
+    words[1] = sizeof(T_TraceEvent);
+    if(fwrite(CODEC_TRACE_MAGIC, 1, 8, f) != 8 || fwrite(words, sizeof(words), 1, f) != 1)
+        return -1;
+
+    for(r = __atomic_load_n(&codec_trace_head, __ATOMIC_ACQUIRE); r != NULL; r = r->next)
+    {
+        tail = r->tail;
+        head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        if(head == tail)
+            continue;
+
+        block.thread = r->thread;
+        block.count = head - tail;
+        block.dropped = __atomic_load_n(&r->dropped, __ATOMIC_RELAXED);
+        if(fwrite(&block, sizeof(block), 1, f) != 1)
+            return -1;
+
+        /*at most two pieces when the range wraps*/
+        first = r->size - (tail & (r->size - 1));
+        if(first > block.count)
+            first = block.count;
+        if(fwrite(&r->events[tail & (r->size - 1)], sizeof(T_TraceEvent), first, f) != first
+           || fwrite(r->events, sizeof(T_TraceEvent), block.count - first, f) != block.count - first)
+            return -1;
+
+        __atomic_store_n(&r->tail, head, __ATOMIC_RELEASE);
+        total += block.count;
+    }
+
+    return total;
+}
+
+#endif
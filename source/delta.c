@@ -0,0 +1,299 @@
+#include <string.h>
+#include "delta.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*a literal ends at the first run of this many unchanged bytes*/
+#define DELTA_MINSKIP  4
+
+/*first position from pos where a and b differ, len if none*/
+static unsigned short delta_nextdiff(const unsigned char *a, const unsigned char *b, unsigned short pos, unsigned short len)
+{
+#if defined(__SSE2__)
+    unsigned int m;
+
+    for(; pos + 16 <= len; pos += 16)
+    {
+        m = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(a + pos)),
+                                             _mm_loadu_si128((const __m128i *)(b + pos))));
+        if(m != 0xFFFF)
+            return pos + __builtin_ctz(~m);
+    }
+#else
+    unsigned long long x, y;
+
+    for(; pos + 8 <= len; pos += 8)
+    {
+        memcpy(&x, a + pos, 8);
+        memcpy(&y, b + pos, 8);
+        if(x != y)
+            break;
+    }
+#endif
+
+    for(; pos < len && a[pos] == b[pos]; pos++)
+        ;
+
+    return pos;
+}
+
+/*end of the changed bytes starting at pos*/
+static unsigned short delta_literalend(const unsigned char *a, const unsigned char *b, unsigned short pos, unsigned short len)
+{
+    unsigned short same = 0;
+
+    for(; pos < len; pos++)
+    {
+        if(a[pos] != b[pos])
+            same = 0;
+        else if(++same == DELTA_MINSKIP)
+            return pos + 1 - DELTA_MINSKIP;
+    }
+
+    return len - same;
+}
+
+/*dst = a ^ b*/
+static void delta_xor(unsigned char *dst, const unsigned char *a, const unsigned char *b, unsigned short n)
+{
+    unsigned short i = 0;
+
+#if defined(__SSE2__)
+    for(; i + 16 <= n; i += 16)
+    {
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_xor_si128(_mm_loadu_si128((const __m128i *)(a + i)),
+                                                             _mm_loadu_si128((const __m128i *)(b + i))));
+    }
+#endif
+
+    for(; i < n; i++)
+        dst[i] = a[i] ^ b[i];
+}
+
+/*room for n more bytes, else the stream error is set*/
+static int delta_reserve(T_ByteStream *buf, unsigned short n)
+{
+    if(buf->curbyte + n > buf->totallen)
+    {
+        buf->error = CODEC_SETTOOBITS;
+        return 0;
+    }
+
+    return 1;
+}
+
+static void delta_putvarint(T_ByteStream *buf, unsigned short value)
+{
+    if(value >= 0x80 && delta_reserve(buf, 2))
+    {
+        if(buf->buffer != NULL)
+        {
+            buf->buffer[buf->curbyte] = (unsigned char)(value | 0x80);
+            buf->buffer[buf->curbyte + 1] = (unsigned char)(value >> 7);
+        }
+        buf->curbyte += 2;
+    }
+    else if(value < 0x80 && delta_reserve(buf, 1))
+    {
+        if(buf->buffer != NULL)
+            buf->buffer[buf->curbyte] = (unsigned char)value;
+        buf->curbyte ++;
+    }
+}
+
+/*values up to 14 bits, the only ones an encoder writes*/
+static unsigned short delta_getvarint(T_ByteStream *buf)
+{
+    unsigned short value;
+
+    if(buf->curbyte + 1 > buf->totallen)
+    {
+        buf->error = CODEC_GETTOOBITS;
+        return 0;
+    }
+
+    value = buf->buffer[buf->curbyte ++];
+    if(value < 0x80)
+        return value;
+
+    if(buf->curbyte + 1 > buf->totallen)
+    {
+        buf->error = CODEC_GETTOOBITS;
+        return 0;
+    }
+
+    return (value & 0x7F) | (buf->buffer[buf->curbyte ++] << 7);
+}
+
+static void delta_setref(T_DeltaFlow *flow, const unsigned char *msg, unsigned short len)
+{
+    if(msg != flow->ref)
+        memcpy(flow->ref, msg, len);
+    if(flow->reflen > len)
+        memset(&flow->ref[len], 0, flow->reflen - len);
+    flow->reflen = len;
+    flow->haveref = 1;
+}
+
+void delta_flowinit(T_DeltaFlow *flow, unsigned short interval)
+{
+    memset(flow->ref, 0, sizeof(flow->ref));
+    flow->reflen = 0;
+    flow->haveref = 0;
+    flow->interval = interval;
+    flow->sincekey = 0;
+}
+
+/*runs are (unchanged + 1, changed - 1) so a single zero byte ends the list*/
+static int delta_putdiff(T_DeltaFlow *flow, const unsigned char *msg, unsigned short len, T_ByteStream *o, unsigned short limit)
+{
+    unsigned short pos, start, end;
+
+    for(pos = 0; ; pos = end)
+    {
+        start = delta_nextdiff(msg, flow->ref, pos, len);
+        if(start == len)
+            break;
+
+        end = delta_literalend(msg, flow->ref, start, len);
+        delta_putvarint(o, start - pos + 1);
+        delta_putvarint(o, end - start - 1);
+        if(o->curbyte >= limit || !delta_reserve(o, end - start))
+            return 0;
+
+        if(o->buffer != NULL)
+            delta_xor(&o->buffer[o->curbyte], &msg[start], &flow->ref[start], end - start);
+        o->curbyte += end - start;
+        if(o->curbyte >= limit)
+            return 0;
+    }
+
+    delta_putvarint(o, 0);
+    return o->error == CODEC_OK && o->curbyte < limit;
+}
+
+unsigned short delta_encode(T_DeltaFlow *flow, const unsigned char *msg, unsigned short len, T_OutputByteStream *out)
+{
+    T_ByteStream *o = &out->bytes;
+    unsigned short start = o->curbyte, error = o->error;
+
+    if(len > MAX_CODEC_BUFFER_LEN)
+    {
+        o->error = CODEC_SETTOOBITS;
+        return o->error;
+    }
+
+    /*a diff must beat the keyframe of 3 + len bytes*/
+    if(flow->haveref && (flow->interval == 0 || flow->sincekey < flow->interval))
+    {
+        obytes_setbyte(out, DELTA_DIFF);
+        obytes_setword(out, len);
+        if(delta_putdiff(flow, msg, len, o, start + 3 + len))
+        {
+            delta_setref(flow, msg, len);
+            flow->sincekey ++;
+            return CODEC_OK;
+        }
+
+        o->curbyte = start;
+        o->error = error;
+    }
+
+    obytes_setbyte(out, DELTA_KEYFRAME);
+    obytes_setword(out, len);
+    if(o->error != CODEC_OK || !delta_reserve(o, len))
+    {
+        o->curbyte = start;
+        return o->error;
+    }
+
+    if(o->buffer != NULL)
+        memcpy(&o->buffer[o->curbyte], msg, len);
+    o->curbyte += len;
+    delta_setref(flow, msg, len);
+    flow->sincekey = 1;
+    return CODEC_OK;
+}
+
+/*check the runs fit the message and the input before touching the reference*/
+static unsigned short delta_checkdiff(T_ByteStream *in, unsigned short len)
+{
+    T_ByteStream probe = *in;
+    unsigned int pos = 0;
+    unsigned short skip, lit;
+
+    for(;;)
+    {
+        skip = delta_getvarint(&probe);
+        if(probe.error != CODEC_OK)
+            return probe.error;
+        if(skip == 0)
+            return CODEC_OK;
+
+        lit = delta_getvarint(&probe) + 1;
+        if(probe.error != CODEC_OK)
+            return probe.error;
+
+        pos += skip - 1 + lit;
+        if(pos > len)
+            return DELTA_CORRUPT;
+        if(probe.curbyte + lit > probe.totallen)
+            return CODEC_GETTOOBITS;
+        probe.curbyte += lit;
+    }
+}
+
+unsigned short delta_decode(T_DeltaFlow *flow, T_InputByteStream *in, T_OutputByteStream *out)
+{
+    T_ByteStream *i = &in->bytes;
+    unsigned short type, len, pos, skip, lit, r;
+
+    type = ibytes_getbyte(in);
+    len = ibytes_getword(in);
+    if(i->error != CODEC_OK)
+        return i->error;
+
+    if(len > MAX_CODEC_BUFFER_LEN || (type != DELTA_KEYFRAME && type != DELTA_DIFF))
+        return DELTA_CORRUPT;
+
+    if(type == DELTA_KEYFRAME)
+    {
+        if(i->curbyte + len > i->totallen)
+        {
+            i->error = CODEC_GETTOOBITS;
+            return i->error;
+        }
+        delta_setref(flow, &i->buffer[i->curbyte], len);
+        i->curbyte += len;
+    }
+    else
+    {
+        r = delta_checkdiff(i, len);
+        if(r != CODEC_OK)
+            return r;
+
+        for(pos = 0; (skip = delta_getvarint(i)) != 0; pos += lit)
+        {
+            pos += skip - 1;
+            lit = delta_getvarint(i) + 1;
+            if(flow->haveref)
+                delta_xor(&flow->ref[pos], &flow->ref[pos], &i->buffer[i->curbyte], lit);
+            i->curbyte += lit;
+        }
+
+        /*the frame is consumed either way, so the caller can wait for a keyframe*/
+        if(!flow->haveref)
+            return DELTA_NOREF;
+        delta_setref(flow, flow->ref, len);
+    }
+
+    if(!delta_reserve(&out->bytes, len))
+        return out->bytes.error;
+
+    if(out->bytes.buffer != NULL)
+        memcpy(&out->bytes.buffer[out->bytes.curbyte], flow->ref, len);
+    out->bytes.curbyte += len;
+    return CODEC_OK;
+}
@@ -0,0 +1,207 @@
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "framefile.h"
+
+typedef struct tagT_FrameWorker {
+    pthread_t thread;
+    T_FrameFile *ff;
+    unsigned int id;
+    unsigned int first, last;     /*frames [first, last)*/
+    T_FrameDecode decode;
+    void *ctx;
+    unsigned long failed;
+} T_FrameWorker;
+
+/*ask for the window after pos unless a previous call already covered it*/
+static void framefile_readahead(const T_FrameFile *ff, size_t pos, size_t *until)
+{
+    size_t start, len;
+
+    if(ff->fd < 0 || pos < *until)
+        return;
+
+    start = pos & ~((size_t)sysconf(_SC_PAGESIZE) - 1);
+    len = FRAMEFILE_WINDOW;
+    if(start + len > ff->size)
+        len = ff->size - start;
+    madvise((void *)(ff->data + start), len, MADV_WILLNEED);
+    *until = start + len;
+}
+
+/*
+ * Each offset depends on the length before it, so the scan is a chain of
+ * dependent loads that cannot be split or vectorized; it stays cheap by
+ * touching only the two prefix bytes per frame and reading ahead.
+ */
+static unsigned short framefile_index(T_FrameFile *ff)
+{
+    size_t pos, until = 0, cap = 1024, *grown;
+    unsigned short len;
+
+    ff->count = 0;
+    ff->failed = 0;
+    ff->bad = ff->size;
+    if((ff->offsets = malloc(cap * sizeof(*ff->offsets))) == NULL)
+        return FRAMEFILE_NOMEM;
+
+    for(pos = 0; pos < ff->size; pos += 2 + len)
+    {
+        framefile_readahead(ff, pos, &until);
+
+        if(pos + 2 > ff->size)
+            len = 0xFFFF;
+        else
+            len = (unsigned short)(ff->data[pos] << 8 | ff->data[pos + 1]);
+        if(len > MAX_CODEC_BUFFER_LEN || pos + 2 + len > ff->size || ff->count == 0xFFFFFFFF)
+        {
+            ff->bad = pos;
+            return FRAMEFILE_BADFRAME;
+        }
+
+        if(ff->count == cap)
+        {
+            if((grown = realloc(ff->offsets, 2 * cap * sizeof(*ff->offsets))) == NULL)
+                return FRAMEFILE_NOMEM;
+            ff->offsets = grown;
+            cap *= 2;
+        }
+        ff->offsets[ff->count++] = pos + 2;
+    }
+
+    return CODEC_OK;
+}
+
+unsigned short framefile_attach(T_FrameFile *ff, const unsigned char *data, size_t size)
+{
+    ff->data = data;
+    ff->size = size;
+    ff->fd = -1;
+    return framefile_index(ff);
+}
+
+unsigned short framefile_open(T_FrameFile *ff, const char *path)
+{
+    struct stat st;
+    void *map = NULL;
+
+    memset(ff, 0, sizeof(*ff));
+    if((ff->fd = open(path, O_RDONLY)) < 0)
+        return FRAMEFILE_NOFILE;
+
+    if(fstat(ff->fd, &st) < 0
+       || (st.st_size > 0 && (map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, ff->fd, 0)) == MAP_FAILED))
+    {
+        close(ff->fd);
+        ff->fd = -1;
+        return FRAMEFILE_NOFILE;
+    }
+
+    ff->data = map;
+    ff->size = st.st_size;
+    return framefile_index(ff);
+}
+
+void framefile_close(T_FrameFile *ff)
+{
+    if(ff->fd >= 0)
+    {
+        if(ff->size)
+            munmap((void *)ff->data, ff->size);
+        close(ff->fd);
+    }
+
+    free(ff->offsets);
+    ff->offsets = NULL;
+    ff->count = 0;
+    ff->fd = -1;
+}
+
+void framefile_frame(T_FrameFile *ff, unsigned int i, T_InputByteStream *msg)
+{
+    const unsigned char *p = ff->data + ff->offsets[i];
+
+    ibytes_init(msg, (unsigned char *)p, (unsigned short)(p[-2] << 8 | p[-1]));
+}
+
+static void *framefile_worker(void *arg)
+{
+    T_FrameWorker *w = arg;
+    T_FrameFile *ff = w->ff;
+    T_InputByteStream msg;
+    size_t until = 0;
+    unsigned int i;
+
+    for(i = w->first; i < w->last; i++)
+    {
+        framefile_readahead(ff, ff->offsets[i], &until);
+        framefile_frame(ff, i, &msg);
+        if(w->decode(w->ctx, w->id, &msg) != CODEC_OK)
+            w->failed ++;
+    }
+
+    return NULL;
+}
+
+/*first frame starting at or after pos*/
+static unsigned int framefile_find(const T_FrameFile *ff, size_t pos)
+{
+    unsigned int lo = 0, hi = ff->count, mid;
+
+    while(lo < hi)
+    {
+        mid = lo + (hi - lo) / 2;
+        if(ff->offsets[mid] - 2 < pos)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    return lo;
+}
+
+unsigned short framefile_run(T_FrameFile *ff, unsigned int nthreads, T_FrameDecode decode, void *ctx)
+{
+    T_FrameWorker workers[FRAMEFILE_MAXTHREADS];
+    unsigned int i, started = 0;
+    size_t end = ff->count ? ff->offsets[ff->count - 1] : 0;
+
+    if(nthreads < 1)
+        nthreads = 1;
+    if(nthreads > FRAMEFILE_MAXTHREADS)
+        nthreads = FRAMEFILE_MAXTHREADS;
+
+    for(i = 0; i < nthreads; i++)
+    {
+        workers[i].ff = ff;
+        workers[i].id = i;
+        workers[i].first = i ? workers[i-1].last : 0;
+        workers[i].last = i + 1 < nthreads ? framefile_find(ff, end / nthreads * (i + 1)) : ff->count;
+        if(workers[i].last < workers[i].first)
+            workers[i].last = workers[i].first;
+        workers[i].decode = decode;
+        workers[i].ctx = ctx;
+        workers[i].failed = 0;
+    }
+
+    /*the caller's thread takes the first part, and any a thread could not be started for*/
+    for(i = 1; i < nthreads && pthread_create(&workers[i].thread, NULL, framefile_worker, &workers[i]) == 0; i++)
+        started ++;
+    for(i = started + 1; i < nthreads; i++)
+        framefile_worker(&workers[i]);
+    framefile_worker(&workers[0]);
+
+    ff->failed = 0;
+    for(i = 0; i < nthreads; i++)
+    {
+        if(i > 0 && i <= started)
+            pthread_join(workers[i].thread, NULL);
+        ff->failed += workers[i].failed;
+    }
+
+    return CODEC_OK;
+}
@@ -0,0 +1,345 @@
+#include <stddef.h>
+#include <pthread.h>
+#include "hdlc.h"
+
+/*one table step: bits are ordered first-bit-in-MSB*/
+typedef struct tagT_HdlcStep {
+    unsigned short bits;
+    unsigned char  len;   /*output bits*/
+    unsigned char  ones;  /*ones count after the step*/
+    unsigned char  used;  /*input bits consumed*/
+} T_HdlcStep;
+
+static T_HdlcStep stufftab[5][256];    /*indexed by ones count 0-4*/
+static T_HdlcStep destufftab[6][256];  /*indexed by ones count 0-5*/
+static unsigned char reverse[256];
+static pthread_once_t tablesonce = PTHREAD_ONCE_INIT;   /*decoders may start on several threads at once*/
+
+static void hdlc_buildtables(void)
+{
+    int s, b, i;
+    unsigned char bit, ones;
+    T_HdlcStep *e;
+
+    for(b=0; b<256; b++)
+    {
+        for(i=0, reverse[b]=0; i<8; i++)
+            reverse[b] |= ((b >> i) & 1) << (7 - i);
+    }
+
+    /*insert a zero after every fifth consecutive one*/
+    for(s=0; s<5; s++)
+    {
+        for(b=0; b<256; b++)
+        {
+            e = &stufftab[s][b];
+            e->bits = 0;
+            e->len = 0;
+            e->used = 8;
+            ones = s;
+            for(i=7; i>=0; i--)
+            {
+                bit = (b >> i) & 1;
+                e->bits = (e->bits << 1) | bit;
+                e->len ++;
+                ones = bit ? ones + 1 : 0;
+                if(ones == 5)
+                {
+                    e->bits <<= 1;
+                    e->len ++;
+                    ones = 0;
+                }
+            }
+            e->ones = ones;
+        }
+    }
+
+    /*drop the zero after five ones, stop at a sixth one (flag or abort)*/
+    for(s=0; s<6; s++)
+    {
+        for(b=0; b<256; b++)
+        {
+            e = &destufftab[s][b];
+            e->bits = 0;
+            e->len = 0;
+            e->used = 8;
+            ones = s;
+            for(i=0; i<8; i++)
+            {
+                bit = (b >> (7 - i)) & 1;
+                if(bit)
+                {
+                    ones ++;
+                    if(ones == 6)
+                    {
+                        e->used = i + 1;
+                        break;
+                    }
+                }
+                else if(ones == 5)
+                {
+                    ones = 0;
+                    continue;
+                }
+                else
+                {
+                    ones = 0;
+                }
+                e->bits = (e->bits << 1) | bit;
+                e->len ++;
+            }
+            e->ones = ones;
+        }
+    }
+}
+
+/*read n (1-8) bits, first bit in bit n-1*/
+static unsigned char hdlc_read(T_InputBitStream *in, unsigned char n)
+{
+    unsigned char v = (unsigned char)ibits_getbit(in, n);
+
+    if(in->bits.order == CODEC_LSB_FIRST)
+        v = reverse[v] >> (8 - n);
+
+    return v;
+}
+
+/*write len (1-10) bits given first bit in bit len-1*/
+static void hdlc_write(T_OutputBitStream *out, unsigned char len, unsigned short bits)
+{
+    if(out->bits.order == CODEC_LSB_FIRST)
+        bits = ((reverse[bits & 0xff] << 8) | reverse[bits >> 8]) >> (16 - len);
+
+    obits_setbit(out, len, bits);
+}
+
+static void hdlc_rewind(T_BitStream *bits, unsigned short n)
+{
+    bits->curbit -= n;
+    bits->curbyte = bits->curbit >> 3;
+}
+
+/*drop the last n output bits, clearing them since setbit merges into the buffer*/
+static void hdlc_retract(T_OutputBitStream *out, unsigned short n)
+{
+    T_BitStream *bits = &out->bits;
+    unsigned short end = (bits->curbit + 7) >> 3;
+    unsigned short i;
+    unsigned char keep;
+
+    hdlc_rewind(bits, n);
+    for(i=bits->curbyte; i<end && bits->buffer != NULL; i++)
+    {
+        keep = 0;
+        if(i == bits->curbyte && (bits->curbit & 7))
+        {
+            if(bits->order == CODEC_LSB_FIRST)
+                keep = (unsigned char)(0xff >> (8 - (bits->curbit & 7)));
+            else
+                keep = (unsigned char)(0xff << (8 - (bits->curbit & 7)));
+        }
+        bits->buffer[i] &= keep;
+    }
+}
+
+unsigned short hdlc_stuff(T_InputBitStream *in, unsigned short n, T_OutputBitStream *out)
+{
+    T_HdlcStep *e;
+    unsigned char ones = 0;
+    unsigned char chunk, bit;
+    int i;
+
+    pthread_once(&tablesonce, hdlc_buildtables);
+
+    for(; n >= 8; n -= 8)
+    {
+        e = &stufftab[ones][hdlc_read(in, 8)];
+        hdlc_write(out, e->len, e->bits);
+        ones = e->ones;
+    }
+
+    if(n > 0)
+    {
+        chunk = hdlc_read(in, (unsigned char)n);
+        for(i=n-1; i>=0; i--)
+        {
+            bit = (chunk >> i) & 1;
+            hdlc_write(out, 1, bit);
+            ones = bit ? ones + 1 : 0;
+            if(ones == 5)
+            {
+                hdlc_write(out, 1, 0);
+                ones = 0;
+            }
+        }
+    }
+
+    if(ibits_geterror(in) != CODEC_OK)
+        return ibits_geterror(in);
+
+    return obits_geterror(out);
+}
+
+unsigned short hdlc_encodeframe(T_InputBitStream *in, unsigned short n, T_OutputBitStream *out)
+{
+    unsigned short error;
+
+    pthread_once(&tablesonce, hdlc_buildtables);    /*the flag goes through reverse[]*/
+    hdlc_write(out, 8, HDLC_FLAG);
+    error = hdlc_stuff(in, n, out);
+    hdlc_write(out, 8, HDLC_FLAG);
+
+    return error != CODEC_OK ? error : obits_geterror(out);
+}
+
+void hdlc_decoderinit(T_HdlcDecoder *dec)
+{
+    dec->hunt = 1;
+    dec->ones = 0;
+    dec->framebits = 0;
+    dec->spill = 0;
+
+    pthread_once(&tablesonce, hdlc_buildtables);
+}
+
+static void hdlc_discard(T_HdlcDecoder *dec, T_OutputBitStream *out)
+{
+    hdlc_retract(out, dec->framebits - dec->spill);
+    dec->framebits = 0;
+    dec->spill = 0;
+    dec->hunt = 1;
+}
+
+/*
+ * Up to six bits taken as data may turn out to be the start of the closing
+ * flag, so that many may go past the end of the output stream before the
+ * frame is known not to fit.
+ */
+static unsigned short hdlc_emit(T_HdlcDecoder *dec, T_OutputBitStream *out, unsigned char len, unsigned short bits)
+{
+    unsigned int room;
+
+    if(dec->hunt || len == 0)
+        return HDLC_NEEDMORE;
+
+    room = 8 * out->bits.totallen - out->bits.curbit;
+    if(dec->spill == 0 && len <= room)
+    {
+        hdlc_write(out, len, bits);
+    }
+    else
+    {
+        room = dec->spill == 0 ? room : 0;
+        if(room > 0)
+            hdlc_write(out, (unsigned char)room, bits >> (len - room));
+        dec->spill += len - room;
+        if(dec->spill > 6)
+        {
+            dec->framebits += len;
+            hdlc_discard(dec, out);
+            return HDLC_OVERFLOW;
+        }
+    }
+
+    dec->framebits += len;
+    return HDLC_NEEDMORE;
+}
+
+static unsigned short hdlc_destuffbit(T_HdlcDecoder *dec, T_OutputBitStream *out, unsigned char bit)
+{
+    unsigned short n;
+
+    if(bit)
+    {
+        if(dec->ones == 7)
+            return HDLC_NEEDMORE;
+
+        dec->ones ++;
+        if(dec->ones < 6)
+            return hdlc_emit(dec, out, 1, 1);
+
+        if(dec->ones == 7 && !dec->hunt)
+        {
+            /*the five ones written before the abort are not data*/
+            n = dec->framebits;
+            hdlc_discard(dec, out);
+            return n > 5 ? HDLC_ABORT : HDLC_NEEDMORE;
+        }
+
+        return HDLC_NEEDMORE;
+    }
+
+    if(dec->ones == 6)
+    {
+        dec->ones = 0;
+        if(dec->hunt)
+        {
+            dec->hunt = 0;
+            return HDLC_NEEDMORE;
+        }
+
+        /*the flag's leading zero and five ones were taken as data*/
+        n = dec->framebits < 6 ? dec->framebits : 6;
+        dec->framebits -= n;
+        if(dec->spill < n)
+            hdlc_retract(out, n - dec->spill);
+        dec->spill = 0;
+        if(dec->framebits == 0)
+            return HDLC_NEEDMORE;
+
+        dec->framebits = 0;
+        return HDLC_FRAME;
+    }
+
+    if(dec->ones == 5 || dec->ones == 7)
+    {
+        dec->ones = 0;
+        return HDLC_NEEDMORE;
+    }
+
+    dec->ones = 0;
+    return hdlc_emit(dec, out, 1, 0);
+}
+
+unsigned short hdlc_decodeframe(T_HdlcDecoder *dec, T_InputBitStream *in, T_OutputBitStream *out)
+{
+    T_HdlcStep *e;
+    unsigned int remain;
+    unsigned char chunk, n, used;
+    unsigned short r;
+    int i;
+
+    remain = 8 * in->bits.totallen - in->bits.curbit;
+    while(remain > 0)
+    {
+        n = remain < 8 ? (unsigned char)remain : 8;
+        chunk = hdlc_read(in, n);
+        remain -= n;
+        used = 0;
+
+        if(n == 8 && dec->ones < 6)
+        {
+            e = &destufftab[dec->ones][chunk];
+            dec->ones = e->ones;
+            used = e->used;
+            r = hdlc_emit(dec, out, e->len, e->bits);
+            if(r != HDLC_NEEDMORE)
+            {
+                ibits_back(in, 8 - used);
+                return r;
+            }
+        }
+
+        for(i=used; i<n; i++)
+        {
+            r = hdlc_destuffbit(dec, out, (chunk >> (n - 1 - i)) & 1);
+            if(r != HDLC_NEEDMORE)
+            {
+                ibits_back(in, n - 1 - i);
+                return r;
+            }
+        }
+    }
+
+    return HDLC_NEEDMORE;
+}
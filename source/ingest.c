@@ -0,0 +1,358 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <linux/io_uring.h>
+#include "ingest.h"
+
+/*slot states*/
+#define INGEST_FREE     0
+#define INGEST_READING  1
+#define INGEST_DONE     2     /*read completed, not handed out yet*/
+#define INGEST_HELD     3     /*handed out, waiting for ingest_release*/
+
+#define INGEST_SLOT(ig, slot)  ((ig)->pool + (size_t)(slot) * MAX_CODEC_BUFFER_LEN)
+
+static void ingest_closering(T_Ingest *ig)
+{
+    if(ig->sqes != NULL)
+        munmap(ig->sqes, ig->sqessize);
+    if(ig->cqmap != NULL && ig->cqmap != ig->sqmap)
+        munmap(ig->cqmap, ig->cqmapsize);
+    if(ig->sqmap != NULL)
+        munmap(ig->sqmap, ig->sqmapsize);
+    if(ig->ring >= 0)
+        close(ig->ring);
+
+    ig->sqes = ig->cqmap = ig->sqmap = NULL;
+    ig->ring = -1;
+}
+
+/*a ring of slots entries with the whole pool as registered buffer 0, -1 if the kernel says no*/
+static int ingest_openring(T_Ingest *ig)
+{
+    struct io_uring_params p;
+    struct iovec iov;
+    unsigned char *sq, *cq;
+
+    memset(&p, 0, sizeof(p));
+    if((ig->ring = (int)syscall(__NR_io_uring_setup, ig->slots, &p)) < 0)
+        return -1;
+
+    ig->sqmapsize = p.sq_off.array + p.sq_entries * sizeof(unsigned int);
+    ig->cqmapsize = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if(p.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if(ig->cqmapsize > ig->sqmapsize)
+            ig->sqmapsize = ig->cqmapsize;
+        ig->cqmapsize = ig->sqmapsize;
+    }
+
+    ig->sqmap = mmap(NULL, ig->sqmapsize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ig->ring, IORING_OFF_SQ_RING);
+    if(ig->sqmap == MAP_FAILED)
+    {
+        ig->sqmap = NULL;
+        ingest_closering(ig);
+        return -1;
+    }
+    if(p.features & IORING_FEAT_SINGLE_MMAP)
+        ig->cqmap = ig->sqmap;
+    else if((ig->cqmap = mmap(NULL, ig->cqmapsize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ig->ring, IORING_OFF_CQ_RING)) == MAP_FAILED)
+    {
+        ig->cqmap = NULL;
+        ingest_closering(ig);
+        return -1;
+    }
+
+    ig->sqessize = p.sq_entries * sizeof(struct io_uring_sqe);
+    if((ig->sqes = mmap(NULL, ig->sqessize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ig->ring, IORING_OFF_SQES)) == MAP_FAILED)
+    {
+        ig->sqes = NULL;
+        ingest_closering(ig);
+        return -1;
+    }
+
+    sq = ig->sqmap;
+    cq = ig->cqmap;
+    ig->sqhead = (unsigned int *)(sq + p.sq_off.head);
+    ig->sqtail = (unsigned int *)(sq + p.sq_off.tail);
+    ig->sqmask = (unsigned int *)(sq + p.sq_off.ring_mask);
+    ig->sqarray = (unsigned int *)(sq + p.sq_off.array);
+    ig->cqhead = (unsigned int *)(cq + p.cq_off.head);
+    ig->cqtail = (unsigned int *)(cq + p.cq_off.tail);
+    ig->cqmask = (unsigned int *)(cq + p.cq_off.ring_mask);
+    ig->cqes = cq + p.cq_off.cqes;
+
+    /*pinned once here, so no read has to map the buffer again*/
+    iov.iov_base = ig->pool;
+    iov.iov_len = (size_t)ig->slots * MAX_CODEC_BUFFER_LEN;
+    if(syscall(__NR_io_uring_register, ig->ring, IORING_REGISTER_BUFFERS, &iov, 1) < 0)
+    {
+        ingest_closering(ig);
+        return -1;
+    }
+
+    return 0;
+}
+
+unsigned short ingest_init(T_Ingest *ig, int fd, unsigned int slots, unsigned short readlen, unsigned int flags)
+{
+    struct stat st;
+    unsigned int i;
+
+    memset(ig, 0, sizeof(*ig));
+    ig->fd = fd;
+    ig->ring = -1;
+    ig->readlen = readlen < MAX_CODEC_BUFFER_LEN ? readlen : MAX_CODEC_BUFFER_LEN;
+    ig->stream = fstat(fd, &st) < 0 || !S_ISREG(st.st_mode);
+    ig->socket = ig->stream && S_ISSOCK(st.st_mode);
+
+    for(ig->slots = 1; ig->slots < slots && ig->slots < INGEST_MAXSLOTS; ig->slots <<= 1)
+        ;
+
+    ig->pool = mmap(NULL, (size_t)ig->slots * MAX_CODEC_BUFFER_LEN, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    ig->results = malloc(ig->slots * sizeof(*ig->results));
+    ig->states = calloc(ig->slots, sizeof(*ig->states));
+    ig->freelist = malloc(ig->slots * sizeof(*ig->freelist));
+    ig->order = malloc(ig->slots * sizeof(*ig->order));
+    if(ig->pool == MAP_FAILED || !ig->results || !ig->states || !ig->freelist || !ig->order)
+    {
+        if(ig->pool == MAP_FAILED)
+            ig->pool = NULL;
+        ingest_free(ig);
+        return INGEST_NOMEM;
+    }
+
+    for(i = 0; i < ig->slots; i++)
+        ig->freelist[i] = ig->slots - 1 - i;
+    ig->nfree = ig->slots;
+
+    if(!(flags & INGEST_BLOCKING))
+        ingest_openring(ig);
+
+    return CODEC_OK;
+}
+
+void ingest_free(T_Ingest *ig)
+{
+    ingest_closering(ig);
+    if(ig->pool != NULL)
+        munmap(ig->pool, (size_t)ig->slots * MAX_CODEC_BUFFER_LEN);
+    free(ig->results);
+    free(ig->states);
+    free(ig->freelist);
+    free(ig->order);
+    ig->pool = NULL;
+    ig->results = NULL;
+    ig->states = NULL;
+    ig->freelist = NULL;
+    ig->order = NULL;
+}
+
+/*the same read as the ring would do, done now*/
+static int ingest_readnow(T_Ingest *ig, unsigned int slot)
+{
+    ssize_t r;
+
+    do
+    {
+        if(ig->stream)
+            r = read(ig->fd, INGEST_SLOT(ig, slot), ig->readlen);
+        else
+            r = pread(ig->fd, INGEST_SLOT(ig, slot), ig->readlen, (off_t)ig->offset);
+    }
+    while(r < 0 && errno == EINTR);
+
+    return r < 0 ? -errno : (int)r;
+}
+
+/*
+ * A socket read is a RECV linked to the next one, because a short READ
+ * cuts a link chain and a short RECV does not; the pool is still pinned
+ * for the other reads.
+ */
+static void ingest_queue(T_Ingest *ig, unsigned int slot, int link)
+{
+    unsigned int tail = *ig->sqtail, idx = tail & *ig->sqmask;
+    struct io_uring_sqe *sqe = (struct io_uring_sqe *)ig->sqes + idx;
+
+    memset(sqe, 0, sizeof(*sqe));
+    sqe->fd = ig->fd;
+    sqe->addr = (unsigned long)INGEST_SLOT(ig, slot);
+    sqe->len = ig->readlen;
+    sqe->user_data = slot;
+    if(ig->socket)
+    {
+        sqe->opcode = IORING_OP_RECV;
+        sqe->flags = link ? IOSQE_IO_LINK : 0;
+    }
+    else
+    {
+        sqe->opcode = IORING_OP_READ_FIXED;
+        sqe->off = ig->stream ? (unsigned long long)-1 : ig->offset;
+        sqe->buf_index = 0;
+    }
+    ig->sqarray[idx] = idx;
+    __atomic_store_n(ig->sqtail, tail + 1, __ATOMIC_RELEASE);
+    ig->pending ++;
+}
+
+/*
+ * Start reads into free slots; without a ring only one, done in place. A
+ * stream only starts reads when none are in flight: a socket then queues
+ * every free slot as one link chain, which the kernel runs one read after
+ * another so messages land in submission order, and other streams take a
+ * single read. Two chains in flight at once could take messages out of
+ * order.
+ */
+static void ingest_fill(T_Ingest *ig)
+{
+    unsigned int slot;
+
+    if(ig->stream && ig->inflight > 0)
+        return;
+
+    while(ig->nfree > 0 && !ig->eof)
+    {
+        slot = ig->freelist[--ig->nfree];
+        ig->order[ig->submitted & (ig->slots - 1)] = slot;
+        ig->submitted ++;
+        ig->inflight ++;
+
+        if(ig->ring >= 0)
+        {
+            ig->states[slot] = INGEST_READING;
+            ingest_queue(ig, slot, ig->nfree > 0);
+        }
+        else
+        {
+            ig->results[slot] = ingest_readnow(ig, slot);
+            ig->states[slot] = INGEST_DONE;
+            ig->inflight --;
+        }
+        ig->offset += ig->readlen;
+
+        if(ig->ring < 0 || (ig->stream && !ig->socket))
+            break;
+    }
+}
+
+static void ingest_reap(T_Ingest *ig)
+{
+    struct io_uring_cqe *cqe;
+    unsigned int head = *ig->cqhead, tail, slot;
+
+    tail = __atomic_load_n(ig->cqtail, __ATOMIC_ACQUIRE);
+    for(; head != tail; head++)
+    {
+        cqe = (struct io_uring_cqe *)ig->cqes + (head & *ig->cqmask);
+        slot = (unsigned int)cqe->user_data;
+        ig->results[slot] = cqe->res;
+        ig->states[slot] = INGEST_DONE;
+        ig->inflight --;
+    }
+    __atomic_store_n(ig->cqhead, head, __ATOMIC_RELEASE);
+}
+
+/*submit what is queued, sleeping for a completion if asked, then collect*/
+static void ingest_enter(T_Ingest *ig, int wait)
+{
+    long r;
+
+    if(ig->pending > 0 || wait)
+    {
+        do
+            r = syscall(__NR_io_uring_enter, ig->ring, ig->pending, wait ? 1 : 0, wait ? IORING_ENTER_GETEVENTS : 0, NULL, 0);
+        while(r < 0 && errno == EINTR);
+
+        if(r > 0)
+            ig->pending -= (unsigned int)r;
+        else if(r < 0 && !ig->oserror)
+            ig->oserror = errno;
+    }
+
+    ingest_reap(ig);
+}
+
+/*hand out completed reads in order, an empty or failed one ends the input*/
+static unsigned int ingest_deliver(T_Ingest *ig, T_InputByteStream *in, unsigned int *ids, unsigned int max)
+{
+    unsigned int n = 0, slot;
+    int r;
+
+    while(n < max && ig->delivered != ig->submitted)
+    {
+        slot = ig->order[ig->delivered & (ig->slots - 1)];
+        if(ig->states[slot] != INGEST_DONE)
+            break;
+
+        ig->delivered ++;
+        r = ig->results[slot];
+        if(r <= 0)
+        {
+            if(r < 0 && !ig->oserror)
+                ig->oserror = -r;
+            ig->eof = 1;
+            ig->states[slot] = INGEST_FREE;
+            ig->freelist[ig->nfree++] = slot;
+            continue;
+        }
+
+        ibytes_init(&in[n], INGEST_SLOT(ig, slot), (unsigned short)r);
+        ids[n++] = slot;
+        ig->states[slot] = INGEST_HELD;
+    }
+
+    return n;
+}
+
+unsigned int ingest_next(T_Ingest *ig, T_InputByteStream *in, unsigned int *ids, unsigned int max)
+{
+    unsigned int n;
+
+    ig->held = 0;
+
+    /*slots released since the last call start reading before anything waits*/
+    if(ig->ring >= 0)
+    {
+        ingest_fill(ig);
+        ingest_enter(ig, 0);
+    }
+
+    for(;;)
+    {
+        n = ingest_deliver(ig, in, ids, max);
+        if(n > 0 || ig->oserror || (ig->eof && ig->delivered == ig->submitted))
+            return n;
+
+        ingest_fill(ig);
+        if(ig->ring >= 0 && ig->inflight > 0)
+            ingest_enter(ig, 1);
+        else if(ig->delivered == ig->submitted)
+        {
+            ig->held = 1;
+            return 0;
+        }
+    }
+}
+
+void ingest_release(T_Ingest *ig, unsigned int id)
+{
+    if(id < ig->slots && ig->states[id] == INGEST_HELD)
+    {
+        ig->states[id] = INGEST_FREE;
+        ig->freelist[ig->nfree++] = id;
+    }
+}
+
+unsigned short ingest_geterror(T_Ingest *ig)
+{
+    if(ig->oserror)
+        return INGEST_IOERROR;
+    return ig->held ? INGEST_ALLHELD : CODEC_OK;
+}
@@ -0,0 +1,262 @@
+#include <stdlib.h>
+#include <string.h>
+#include "msgcache.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <nmmintrin.h>
+#define MSGCACHE_HWCRC
+#endif
+
+static unsigned int crctab[8][256];
+static pthread_once_t crconce = PTHREAD_ONCE_INIT;
+
+/*CRC32C (Castagnoli), reflected polynomial 0x82F63B78, slice-by-8 tables, built once under crconce*/
+static void msgcache_buildtable(void)
+{
+    unsigned int c, i, j;
+
+    for(i=0; i<256; i++)
+    {
+        for(c=i, j=0; j<8; j++)
+            c = (c >> 1) ^ (c & 1 ? 0x82F63B78 : 0);
+        crctab[0][i] = c;
+    }
+
+    for(i=0; i<256; i++)
+    {
+        for(j=1; j<8; j++)
+            crctab[j][i] = (crctab[j-1][i] >> 8) ^ crctab[0][crctab[j-1][i] & 0xff];
+    }
+}
+
+static unsigned int msgcache_crcsw(const unsigned char *p, unsigned short len)
+{
+    unsigned int c = 0xFFFFFFFF, lo, hi;
+
+    for(; len >= 8; len -= 8, p += 8)
+    {
+        lo = c ^ ((unsigned int)p[0] | (p[1] << 8) | (p[2] << 16) | ((unsigned int)p[3] << 24));
+        hi = (unsigned int)p[4] | (p[5] << 8) | (p[6] << 16) | ((unsigned int)p[7] << 24);
+        c = crctab[7][lo & 0xff] ^ crctab[6][(lo >> 8) & 0xff] ^ crctab[5][(lo >> 16) & 0xff] ^ crctab[4][lo >> 24]
+          ^ crctab[3][hi & 0xff] ^ crctab[2][(hi >> 8) & 0xff] ^ crctab[1][(hi >> 16) & 0xff] ^ crctab[0][hi >> 24];
+    }
+
+    for(; len > 0; len--, p++)
+        c = (c >> 8) ^ crctab[0][(c ^ *p) & 0xff];
+
+    return ~c;
+}
+
+#ifdef MSGCACHE_HWCRC
+/*the SSE4.2 crc32 instruction computes the same CRC32C*/
+__attribute__((target("sse4.2")))
+static unsigned int msgcache_crchw(const unsigned char *p, unsigned short len)
+{
+    unsigned int c = 0xFFFFFFFF;
+#if defined(__x86_64__)
+    unsigned long long c64 = c, w;
+
+    for(; len >= 8; len -= 8, p += 8)
+    {
+        memcpy(&w, p, 8);
+        c64 = _mm_crc32_u64(c64, w);
+    }
+    c = (unsigned int)c64;
+#endif
+
+    for(; len > 0; len--, p++)
+        c = _mm_crc32_u8(c, *p);
+
+    return ~c;
+}
+#endif
+
+unsigned int msgcache_hash(const unsigned char *msg, unsigned short len)
+{
+#ifdef MSGCACHE_HWCRC
+    if(__builtin_cpu_supports("sse4.2"))
+        return msgcache_crchw(msg, len);
+#endif
+
+    pthread_once(&crconce, msgcache_buildtable);
+
+    return msgcache_crcsw(msg, len);
+}
+
+unsigned short msgcache_init(T_MsgCache *cache, unsigned int nshards, unsigned int slots,
+                             unsigned short maxlen, unsigned int valuesize,
+                             T_MsgCacheDecode decode, void *ctx)
+{
+    unsigned int i;
+    T_MsgCacheShard *s;
+
+    /*round shards up to a power of two and slots to whole probe windows*/
+    for(cache->nshards = 1; cache->nshards < nshards; cache->nshards <<= 1)
+        ;
+    cache->slots = (slots + MSGCACHE_WAYS - 1) / MSGCACHE_WAYS * MSGCACHE_WAYS;
+    if(cache->slots == 0)
+        cache->slots = MSGCACHE_WAYS;
+    cache->maxlen = maxlen;
+    cache->valuesize = valuesize;
+    cache->decode = decode;
+    cache->ctx = ctx;
+
+    cache->shards = calloc(cache->nshards, sizeof(T_MsgCacheShard));
+    if(cache->shards == NULL)
+        return MSGCACHE_NOMEM;
+
+    for(i=0; i<cache->nshards; i++)
+    {
+        s = &cache->shards[i];
+        pthread_rwlock_init(&s->lock, NULL);
+        s->hashes = calloc(cache->slots, sizeof(*s->hashes));
+        s->lens = calloc(cache->slots, sizeof(*s->lens));
+        s->refs = calloc(cache->slots, sizeof(*s->refs));
+        s->raw = malloc((size_t)cache->slots * (maxlen ? maxlen : 1));
+        s->values = malloc((size_t)cache->slots * (valuesize ? valuesize : 1));
+        if(!s->hashes || !s->lens || !s->refs || !s->raw || !s->values)
+        {
+            cache->nshards = i + 1;
+            msgcache_free(cache);
+            return MSGCACHE_NOMEM;
+        }
+    }
+
+    return CODEC_OK;
+}
+
+void msgcache_free(T_MsgCache *cache)
+{
+    unsigned int i;
+    T_MsgCacheShard *s;
+
+    if(cache->shards == NULL)
+        return;
+
+    for(i=0; i<cache->nshards; i++)
+    {
+        s = &cache->shards[i];
+        pthread_rwlock_destroy(&s->lock);
+        free(s->hashes);
+        free(s->lens);
+        free(s->refs);
+        free(s->raw);
+        free(s->values);
+    }
+
+    free(cache->shards);
+    cache->shards = NULL;
+}
+
+/*slot holding msg in the window at base, or -1*/
+static int msgcache_find(T_MsgCache *cache, T_MsgCacheShard *s, unsigned int base,
+                         unsigned int h, const unsigned char *msg, unsigned short len)
+{
+    unsigned int i, k;
+
+    for(i=0; i<MSGCACHE_WAYS; i++)
+    {
+        k = base + i;
+        if(s->lens[k] == len && s->hashes[k] == h && memcmp(&s->raw[(size_t)k * cache->maxlen], msg, len) == 0)
+            return k;
+    }
+
+    return -1;
+}
+
+/*empty slot of the window if any, else the first one CLOCK finds unreferenced*/
+static unsigned int msgcache_victim(T_MsgCacheShard *s, unsigned int base)
+{
+    unsigned int i, k;
+
+    for(i=0; i<MSGCACHE_WAYS; i++)
+    {
+        if(s->lens[base + i] == 0)
+            return base + i;
+    }
+
+    for(;;)
+    {
+        k = base + s->hand++ % MSGCACHE_WAYS;
+        if(s->refs[k] == 0)
+            break;
+        s->refs[k] = 0;
+    }
+
+    __atomic_fetch_add(&s->stats.evictions, 1, __ATOMIC_RELAXED);
+    return k;
+}
+
+unsigned short msgcache_decode(T_MsgCache *cache, unsigned char *msg, unsigned short len, void *value)
+{
+    T_InputByteStream in;
+    T_MsgCacheShard *s;
+    unsigned int h, base, k;
+    unsigned short r;
+    int found;
+
+    if(len == 0 || len > cache->maxlen)
+    {
+        s = &cache->shards[0];
+        __atomic_fetch_add(&s->stats.bypassed, 1, __ATOMIC_RELAXED);
+        ibytes_init(&in, msg, len);
+        return cache->decode(cache->ctx, &in, value);
+    }
+
+    h = msgcache_hash(msg, len);
+    s = &cache->shards[h & (cache->nshards - 1)];
+    base = (h >> 16) % (cache->slots / MSGCACHE_WAYS) * MSGCACHE_WAYS;
+
+    pthread_rwlock_rdlock(&s->lock);
+    found = msgcache_find(cache, s, base, h, msg, len);
+    if(found >= 0)
+    {
+        memcpy(value, &s->values[(size_t)found * cache->valuesize], cache->valuesize);
+        __atomic_store_n(&s->refs[found], 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&s->stats.hits, 1, __ATOMIC_RELAXED);
+        pthread_rwlock_unlock(&s->lock);
+        return CODEC_OK;
+    }
+    pthread_rwlock_unlock(&s->lock);
+
+    /*decode outside the lock, another thread may insert the same message meanwhile*/
+    ibytes_init(&in, msg, len);
+    r = cache->decode(cache->ctx, &in, value);
+    if(r != CODEC_OK)
+    {
+        __atomic_fetch_add(&s->stats.bypassed, 1, __ATOMIC_RELAXED);
+        return r;
+    }
+
+    pthread_rwlock_wrlock(&s->lock);
+    __atomic_fetch_add(&s->stats.misses, 1, __ATOMIC_RELAXED);
+    if(msgcache_find(cache, s, base, h, msg, len) < 0)
+    {
+        k = msgcache_victim(s, base);
+        s->hashes[k] = h;
+        s->lens[k] = len;
+        s->refs[k] = 0;
+        memcpy(&s->raw[(size_t)k * cache->maxlen], msg, len);
+        memcpy(&s->values[(size_t)k * cache->valuesize], value, cache->valuesize);
+    }
+    pthread_rwlock_unlock(&s->lock);
+
+    return CODEC_OK;
+}
+
+/*totals over all shards, each counter read on its own*/
+void msgcache_getstats(T_MsgCache *cache, T_MsgCacheStats *stats)
+{
+    unsigned int i;
+    T_MsgCacheShard *s;
+
+    memset(stats, 0, sizeof(*stats));
+    for(i=0; i<cache->nshards; i++)
+    {
+        s = &cache->shards[i];
+        stats->hits += __atomic_load_n(&s->stats.hits, __ATOMIC_RELAXED);
+        stats->misses += __atomic_load_n(&s->stats.misses, __ATOMIC_RELAXED);
+        stats->evictions += __atomic_load_n(&s->stats.evictions, __ATOMIC_RELAXED);
+        stats->bypassed += __atomic_load_n(&s->stats.bypassed, __ATOMIC_RELAXED);
+    }
+}
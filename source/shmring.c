@@ -0,0 +1,242 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "shmring.h"
+
+#define SHMRING_SPIN  256     /*polls before a waiter goes to sleep*/
+
+#define SHMRING_ALIGN(x, a)  (((x) + (a) - 1) & ~(size_t)((a) - 1))
+
+static size_t shmring_lensoffset(void)
+{
+    return SHMRING_ALIGN(sizeof(T_ShmRingControl), 64);
+}
+
+static size_t shmring_dataoffset(unsigned int slots)
+{
+    return SHMRING_ALIGN(shmring_lensoffset() + slots * sizeof(unsigned short), 4096);
+}
+
+static unsigned short shmring_map(T_ShmRing *ring, int fd, size_t size)
+{
+    void *p = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if(p == MAP_FAILED)
+        return SHMRING_NOMEM;
+
+    ring->fd = fd;
+    ring->size = size;
+    ring->ctl = p;
+    ring->lens = (unsigned short *)((unsigned char *)p + shmring_lensoffset());
+    ring->data = (unsigned char *)p + shmring_dataoffset(ring->slots);
+    ring->limit = 0;
+    return CODEC_OK;
+}
+
+unsigned short shmring_create(T_ShmRing *ring, unsigned int slots, unsigned short slotsize)
+{
+    size_t size;
+    int fd;
+
+    if(slots == 0 || (slots & (slots - 1)) != 0 || slots > 0x10000 || slotsize == 0 || slotsize > MAX_CODEC_BUFFER_LEN)
+        return SHMRING_BADRING;
+
+    ring->slots = slots;
+    ring->slotsize = slotsize;
+    ring->stride = SHMRING_ALIGN(slotsize, 64);
+    size = shmring_dataoffset(slots) + (size_t)slots * ring->stride;
+
+    if((fd = memfd_create("shmring", MFD_CLOEXEC)) < 0)
+        return SHMRING_NOMEM;
+    if(ftruncate(fd, size) < 0 || shmring_map(ring, fd, size) != CODEC_OK)
+    {
+        close(fd);
+        return SHMRING_NOMEM;
+    }
+
+    /*the file starts zeroed, so head, tail and every length already are*/
+    ring->ctl->slots = slots;
+    ring->ctl->slotsize = slotsize;
+    ring->ctl->stride = ring->stride;
+    __atomic_store_n(&ring->ctl->magic, SHMRING_MAGIC, __ATOMIC_RELEASE);
+    return CODEC_OK;
+}
+
+/*maps a ring received from the creator, the fd is owned by the ring afterwards*/
+unsigned short shmring_open(T_ShmRing *ring, int fd)
+{
+    T_ShmRingControl ctl;
+    struct stat st;
+
+    if(fstat(fd, &st) < 0 || st.st_size < (off_t)sizeof(ctl) || pread(fd, &ctl, sizeof(ctl), 0) != sizeof(ctl))
+        return SHMRING_BADRING;
+
+    /*checked once here, the fast paths trust the local copies only*/
+    if(ctl.magic != SHMRING_MAGIC || ctl.slots == 0 || (ctl.slots & (ctl.slots - 1)) != 0 || ctl.slots > 0x10000
+       || ctl.slotsize == 0 || ctl.slotsize > MAX_CODEC_BUFFER_LEN || ctl.stride != SHMRING_ALIGN(ctl.slotsize, 64)
+       || (size_t)st.st_size < shmring_dataoffset(ctl.slots) + (size_t)ctl.slots * ctl.stride)
+        return SHMRING_BADRING;
+
+    ring->slots = ctl.slots;
+    ring->slotsize = (unsigned short)ctl.slotsize;
+    ring->stride = ctl.stride;
+    return shmring_map(ring, fd, shmring_dataoffset(ctl.slots) + (size_t)ctl.slots * ctl.stride);
+}
+
+void shmring_close(T_ShmRing *ring)
+{
+    munmap(ring->ctl, ring->size);
+    close(ring->fd);
+    ring->ctl = NULL;
+    ring->fd = -1;
+}
+
+/*
+ * Sleep until *word moves from seen. The flag is raised before the final
+ * check and the other side reads it after its counter store, both seq_cst,
+ * so either the waker sees the flag or the waiter sees the new counter.
+ */
+static void shmring_wait(unsigned int *word, unsigned int *flag, unsigned int seen)
+{
+    unsigned int i;
+
+    for(i=0; i<SHMRING_SPIN; i++)
+    {
+        if(__atomic_load_n(word, __ATOMIC_ACQUIRE) != seen)
+            return;
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    __atomic_store_n(flag, 1, __ATOMIC_SEQ_CST);
+    if(__atomic_load_n(word, __ATOMIC_SEQ_CST) == seen)
+        syscall(SYS_futex, word, FUTEX_WAIT, seen, NULL, NULL, 0);
+    __atomic_store_n(flag, 0, __ATOMIC_RELAXED);
+}
+
+static void shmring_advance(unsigned int *word, unsigned int *flag)
+{
+    __atomic_store_n(word, *word + 1, __ATOMIC_SEQ_CST);
+    if(__atomic_load_n(flag, __ATOMIC_SEQ_CST))
+        syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
+
+/*free slot for the producer, limit is tail + slots*/
+static unsigned char *shmring_free(T_ShmRing *ring, int wait, unsigned short *error)
+{
+    T_ShmRingControl *ctl = ring->ctl;
+    unsigned int head = ctl->head, tail;
+
+    while((int)(ring->limit - head) <= 0)
+    {
+        tail = __atomic_load_n(&ctl->tail, __ATOMIC_ACQUIRE);
+        ring->limit = tail + ring->slots;
+        if((int)(ring->limit - head) > 0)
+            break;
+        if(!wait)
+        {
+            *error = SHMRING_FULL;
+            return NULL;
+        }
+        shmring_wait(&ctl->tail, &ctl->producerwaits, tail);
+    }
+
+    *error = CODEC_OK;
+    return &ring->data[(size_t)(head & (ring->slots - 1)) * ring->stride];
+}
+
+/*published slot for the consumer, limit is head*/
+static unsigned char *shmring_ready(T_ShmRing *ring, int wait, unsigned short *len, unsigned short *error)
+{
+    T_ShmRingControl *ctl = ring->ctl;
+    unsigned int tail = ctl->tail, head;
+
+    while((int)(ring->limit - tail) <= 0)
+    {
+        head = __atomic_load_n(&ctl->head, __ATOMIC_ACQUIRE);
+        ring->limit = head;
+        if((int)(ring->limit - tail) > 0)
+            break;
+        if(!wait)
+        {
+            *error = SHMRING_EMPTY;
+            return NULL;
+        }
+        shmring_wait(&ctl->head, &ctl->consumerwaits, head);
+    }
+
+    /*the length comes from the other process, never trust it past the slot*/
+    *len = ring->lens[tail & (ring->slots - 1)];
+    if(*len > ring->slotsize)
+        *len = ring->slotsize;
+    *error = CODEC_OK;
+    return &ring->data[(size_t)(tail & (ring->slots - 1)) * ring->stride];
+}
+
+unsigned short shmring_reserve(T_ShmRing *ring, T_OutputByteStream *out, int wait)
+{
+    unsigned short error;
+    unsigned char *slot = shmring_free(ring, wait, &error);
+
+    /*byte writes overwrite, so the slot is not cleared: init over nothing, then widen*/
+    if(slot != NULL)
+    {
+        obytes_init(out, slot, 0);
+        out->bytes.totallen = ring->slotsize;
+    }
+    return error;
+}
+
+unsigned short shmring_reservebits(T_ShmRing *ring, T_OutputBitStream *out, int wait)
+{
+    unsigned short error;
+    unsigned char *slot = shmring_free(ring, wait, &error);
+
+    /*setbit merges into the buffer, so this one is*/
+    if(slot != NULL)
+        obits_init(out, slot, ring->slotsize);
+    return error;
+}
+
+/*len in bytes, (obits_getlen + 7) / 8 for a bit stream*/
+void shmring_publish(T_ShmRing *ring, unsigned short len)
+{
+    T_ShmRingControl *ctl = ring->ctl;
+
+    ring->lens[ctl->head & (ring->slots - 1)] = len;
+    shmring_advance(&ctl->head, &ctl->consumerwaits);
+}
+
+unsigned short shmring_acquire(T_ShmRing *ring, T_InputByteStream *in, int wait)
+{
+    unsigned short error, len;
+    unsigned char *slot = shmring_ready(ring, wait, &len, &error);
+
+    if(slot != NULL)
+        ibytes_init(in, slot, len);
+    return error;
+}
+
+unsigned short shmring_acquirebits(T_ShmRing *ring, T_InputBitStream *in, int wait)
+{
+    unsigned short error, len;
+    unsigned char *slot = shmring_ready(ring, wait, &len, &error);
+
+    if(slot != NULL)
+        ibits_init(in, slot, len);
+    return error;
+}
+
+void shmring_release(T_ShmRing *ring)
+{
+    T_ShmRingControl *ctl = ring->ctl;
+
+    shmring_advance(&ctl->tail, &ctl->producerwaits);
+}
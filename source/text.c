@@ -0,0 +1,370 @@
+#include <stddef.h>
+#include "text.h"
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+/*base64 needs pshufb; built for SSSE3 here and picked at run time, the tree builds for the baseline*/
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <tmmintrin.h>
+#define TEXT_SSSE3         __attribute__((target("ssse3")))
+#define TEXT_HAVESSSE3()   __builtin_cpu_supports("ssse3")
+#endif
+
+static const char hexdigits[] = "0123456789abcdef";
+static const char b64digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+/*value of each ASCII character, 0xFF outside the alphabet*/
+static const unsigned char hexvalue[128] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E, 0x0F, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+    };
+
+static const unsigned char b64value[128] = {
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0x3E, 0xFF, 0xFF, 0xFF, 0x3F,
+    0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3A, 0x3B, 0x3C, 0x3D, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0A, 0x0B, 0x0C, 0x0D, 0x0E,
+    0x0F, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0x1A, 0x1B, 0x1C, 0x1D, 0x1E, 0x1F, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2A, 0x2B, 0x2C, 0x2D, 0x2E, 0x2F, 0x30, 0x31, 0x32, 0x33, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF
+    };
+
+#define TEXT_HEXVALUE(c)  ((c) < 128 ? hexvalue[c] : 0xFF)
+#define TEXT_B64VALUE(c)  ((c) < 128 ? b64value[c] : 0xFF)
+
+/*room for n more bytes, else the stream error is set*/
+static int text_reserve(T_ByteStream *o, unsigned int n)
+{
+    if(o->curbyte + n > o->totallen)
+    {
+        o->error = CODEC_SETTOOBITS;
+        return 0;
+    }
+
+    return 1;
+}
+
+/*hex*/
+static void text_tohex(const unsigned char *src, unsigned int n, unsigned char *dst)
+{
+    unsigned int i = 0;
+#if defined(__SSE2__)
+    const __m128i low = _mm_set1_epi8(0x0F), nine = _mm_set1_epi8(9);
+    const __m128i zero = _mm_set1_epi8('0'), gap = _mm_set1_epi8('a' - '0' - 10);
+    __m128i x, hi, lo;
+
+    for(; i + 16 <= n; i += 16)
+    {
+        x = _mm_loadu_si128((const __m128i *)(src + i));
+        hi = _mm_and_si128(_mm_srli_epi16(x, 4), low);
+        lo = _mm_and_si128(x, low);
+        hi = _mm_add_epi8(_mm_add_epi8(hi, zero), _mm_and_si128(_mm_cmpgt_epi8(hi, nine), gap));
+        lo = _mm_add_epi8(_mm_add_epi8(lo, zero), _mm_and_si128(_mm_cmpgt_epi8(lo, nine), gap));
+        _mm_storeu_si128((__m128i *)(dst + 2 * i), _mm_unpacklo_epi8(hi, lo));
+        _mm_storeu_si128((__m128i *)(dst + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+    }
+#endif
+
+    for(; i < n; i++)
+    {
+        dst[2 * i] = hexdigits[src[i] >> 4];
+        dst[2 * i + 1] = hexdigits[src[i] & 0x0F];
+    }
+}
+
+#if defined(__SSE2__)
+/*nibble of each character, clearing lanes of ok where it is not a hex digit*/
+static __m128i text_hexnibbles(__m128i c, __m128i *ok)
+{
+    __m128i digit, letter, isdigit, isletter;
+
+    digit = _mm_sub_epi8(c, _mm_set1_epi8('0'));
+    letter = _mm_sub_epi8(_mm_or_si128(c, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    isdigit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    isletter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+    *ok = _mm_and_si128(*ok, _mm_or_si128(isdigit, isletter));
+
+    return _mm_or_si128(_mm_and_si128(isdigit, digit),
+                        _mm_and_si128(isletter, _mm_add_epi8(letter, _mm_set1_epi8(10))));
+}
+#endif
+
+/*0 when any character is outside the alphabet*/
+static int text_checkhex(const unsigned char *src, unsigned int n)
+{
+    unsigned int i = 0;
+#if defined(__SSE2__)
+    __m128i ok = _mm_set1_epi8(-1);
+
+    for(; i + 32 <= n; i += 32)
+    {
+        text_hexnibbles(_mm_loadu_si128((const __m128i *)(src + i)), &ok);
+        text_hexnibbles(_mm_loadu_si128((const __m128i *)(src + i + 16)), &ok);
+        if(_mm_movemask_epi8(ok) != 0xFFFF)
+            return 0;
+    }
+#endif
+
+    for(; i < n; i++)
+        if(TEXT_HEXVALUE(src[i]) & 0xF0)
+            return 0;
+
+    return 1;
+}
+
+/*n even, every character checked already*/
+static void text_fromhex(const unsigned char *src, unsigned int n, unsigned char *dst)
+{
+    unsigned int i = 0;
+#if defined(__SSE2__)
+    const __m128i high = _mm_set1_epi16(0x00F0);
+    __m128i a, b, ok = _mm_set1_epi8(-1);
+
+    for(; i + 32 <= n; i += 32)
+    {
+        a = text_hexnibbles(_mm_loadu_si128((const __m128i *)(src + i)), &ok);
+        b = text_hexnibbles(_mm_loadu_si128((const __m128i *)(src + i + 16)), &ok);
+
+        /*each 16-bit lane holds a pair of nibbles, first one in the low byte*/
+        a = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(a, 4), high), _mm_srli_epi16(a, 8));
+        b = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(b, 4), high), _mm_srli_epi16(b, 8));
+        _mm_storeu_si128((__m128i *)(dst + i / 2), _mm_packus_epi16(a, b));
+    }
+#endif
+
+    for(; i < n; i += 2)
+        dst[i / 2] = (unsigned char)(TEXT_HEXVALUE(src[i]) << 4 | TEXT_HEXVALUE(src[i + 1]));
+}
+
+unsigned short text_hexencode(const unsigned char *src, unsigned short n, T_OutputByteStream *out)
+{
+    T_ByteStream *o = &out->bytes;
+
+    if(!text_reserve(o, TEXT_HEXLEN((unsigned int)n)))
+        return o->error;
+
+    if(o->buffer != NULL)
+        text_tohex(src, n, &o->buffer[o->curbyte]);
+    o->curbyte += TEXT_HEXLEN(n);
+    return CODEC_OK;
+}
+
+unsigned short text_hexdecode(const char *src, unsigned int n, T_OutputByteStream *out)
+{
+    T_ByteStream *o = &out->bytes;
+    const unsigned char *s = (const unsigned char *)src;
+
+    if(n & 1)
+        return TEXT_BADLENGTH;
+    if(!text_reserve(o, n / 2))
+        return o->error;
+
+    /*checked whole before writing, so a bad character leaves the buffer as it was*/
+    if(!text_checkhex(s, n))
+        return TEXT_BADCHAR;
+    if(o->buffer != NULL)
+        text_fromhex(s, n, &o->buffer[o->curbyte]);
+
+    o->curbyte += n / 2;
+    return CODEC_OK;
+}
+
+/*base64*/
+#if defined(TEXT_SSSE3)
+/*12 bytes to 16 characters per step, reading 16; returns the bytes done*/
+TEXT_SSSE3 static unsigned int text_tob64ssse3(const unsigned char *src, unsigned int n, unsigned char *dst)
+{
+    const __m128i shuf = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                          '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+    __m128i in, ac, bd, idx, sel;
+    unsigned int i;
+
+    for(i = 0; i + 16 <= n; i += 12, dst += 16)
+    {
+        /*each 32-bit lane gets bytes b1 b0 b2 b1 of a triple, then the four 6-bit fields are moved to bytes*/
+        in = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(src + i)), shuf);
+        ac = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0FC0FC00)), _mm_set1_epi32(0x04000040));
+        bd = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003F03F0)), _mm_set1_epi32(0x01000010));
+        idx = _mm_or_si128(ac, bd);
+
+        /*0-25 use entry 13, 26-51 entry 0, 52-63 entries 1-12*/
+        sel = _mm_subs_epu8(idx, _mm_set1_epi8(51));
+        sel = _mm_or_si128(sel, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), idx), _mm_set1_epi8(13)));
+        _mm_storeu_si128((__m128i *)dst, _mm_add_epi8(_mm_shuffle_epi8(offsets, sel), idx));
+    }
+
+    return i;
+}
+
+/*
+ * 16 characters a step, returning those passed. The nibble tables flag
+ * every character outside the alphabet, '=' included, and the loop stops
+ * at the first step holding one.
+ */
+TEXT_SSSE3 static unsigned int text_checkb64ssse3(const unsigned char *src, unsigned int n)
+{
+    const __m128i lutlo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                        0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+    const __m128i luthi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                        0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+    const __m128i low = _mm_set1_epi8(0x0F);
+    __m128i in;
+    unsigned int i;
+
+    for(i = 0; i + 16 <= n; i += 16)
+    {
+        in = _mm_loadu_si128((const __m128i *)(src + i));
+        if(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(_mm_shuffle_epi8(lutlo, _mm_and_si128(in, low)),
+                                                          _mm_shuffle_epi8(luthi, _mm_and_si128(_mm_srli_epi32(in, 4), low))),
+                                            _mm_setzero_si128())))
+            break;
+    }
+
+    return i;
+}
+
+/*16 checked characters to 12 bytes per step while 16 bytes can be written inside room*/
+TEXT_SSSE3 static unsigned int text_fromb64ssse3(const unsigned char *src, unsigned int n, unsigned char *dst, unsigned int room)
+{
+    const __m128i lutroll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+    const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+    const __m128i low = _mm_set1_epi8(0x0F);
+    __m128i in, hi, v;
+    unsigned int i;
+
+    for(i = 0; i + 16 <= n && i / 4 * 3 + 16 <= room; i += 16)
+    {
+        in = _mm_loadu_si128((const __m128i *)(src + i));
+        hi = _mm_and_si128(_mm_srli_epi32(in, 4), low);
+        v = _mm_add_epi8(in, _mm_shuffle_epi8(lutroll, _mm_add_epi8(_mm_cmpeq_epi8(in, _mm_set1_epi8('/')), hi)));
+        v = _mm_maddubs_epi16(v, _mm_set1_epi32(0x01400140));
+        v = _mm_madd_epi16(v, _mm_set1_epi32(0x00011000));
+        _mm_storeu_si128((__m128i *)(dst + i / 4 * 3), _mm_shuffle_epi8(v, pack));
+    }
+
+    return i;
+}
+#endif
+
+static void text_tob64(const unsigned char *src, unsigned int n, unsigned char *dst)
+{
+    unsigned int i = 0, o, v;
+
+#if defined(TEXT_SSSE3)
+    if(TEXT_HAVESSSE3())
+        i = text_tob64ssse3(src, n, dst);
+#endif
+
+    for(o = i / 3 * 4; i + 3 <= n; i += 3, o += 4)
+    {
+        v = src[i] << 16 | src[i + 1] << 8 | src[i + 2];
+        dst[o] = b64digits[v >> 18];
+        dst[o + 1] = b64digits[(v >> 12) & 0x3F];
+        dst[o + 2] = b64digits[(v >> 6) & 0x3F];
+        dst[o + 3] = b64digits[v & 0x3F];
+    }
+
+    if(i < n)
+    {
+        v = src[i] << 16 | (i + 1 < n ? src[i + 1] << 8 : 0);
+        dst[o] = b64digits[v >> 18];
+        dst[o + 1] = b64digits[(v >> 12) & 0x3F];
+        dst[o + 2] = i + 1 < n ? b64digits[(v >> 6) & 0x3F] : '=';
+        dst[o + 3] = '=';
+    }
+}
+
+/*0 when any character is outside the alphabet*/
+static int text_checkb64(const unsigned char *src, unsigned int n)
+{
+    unsigned int i = 0;
+
+#if defined(TEXT_SSSE3)
+    if(TEXT_HAVESSSE3())
+        i = text_checkb64ssse3(src, n);
+#endif
+
+    for(; i < n; i++)
+        if(TEXT_B64VALUE(src[i]) & 0xC0)
+            return 0;
+
+    return 1;
+}
+
+/*n a multiple of 4 ending in pads '=', every other character checked already*/
+static void text_fromb64(const unsigned char *src, unsigned int n, unsigned int pads, unsigned char *dst)
+{
+    unsigned int i = 0, o, a, b, c, d, body = pads ? n - 4 : n;
+
+#if defined(TEXT_SSSE3)
+    if(TEXT_HAVESSSE3())
+        i = text_fromb64ssse3(src, body, dst, n / 4 * 3 - pads);
+#endif
+
+    for(o = i / 4 * 3; i < body; i += 4, o += 3)
+    {
+        a = TEXT_B64VALUE(src[i]);
+        b = TEXT_B64VALUE(src[i + 1]);
+        c = TEXT_B64VALUE(src[i + 2]);
+        d = TEXT_B64VALUE(src[i + 3]);
+        dst[o] = (unsigned char)(a << 2 | b >> 4);
+        dst[o + 1] = (unsigned char)(b << 4 | c >> 2);
+        dst[o + 2] = (unsigned char)(c << 6 | d);
+    }
+
+    if(pads)
+    {
+        a = TEXT_B64VALUE(src[i]);
+        b = TEXT_B64VALUE(src[i + 1]);
+        c = pads == 1 ? TEXT_B64VALUE(src[i + 2]) : 0;
+        dst[o] = (unsigned char)(a << 2 | b >> 4);
+        if(pads == 1)
+            dst[o + 1] = (unsigned char)(b << 4 | c >> 2);
+    }
+}
+
+unsigned short text_b64encode(const unsigned char *src, unsigned short n, T_OutputByteStream *out)
+{
+    T_ByteStream *o = &out->bytes;
+
+    if(!text_reserve(o, TEXT_B64LEN((unsigned int)n)))
+        return o->error;
+
+    if(o->buffer != NULL)
+        text_tob64(src, n, &o->buffer[o->curbyte]);
+    o->curbyte += TEXT_B64LEN(n);
+    return CODEC_OK;
+}
+
+unsigned short text_b64decode(const char *src, unsigned int n, T_OutputByteStream *out)
+{
+    T_ByteStream *o = &out->bytes;
+    const unsigned char *s = (const unsigned char *)src;
+    unsigned int pads = 0;
+
+    if(n & 3)
+        return TEXT_BADLENGTH;
+    if(n > 0 && s[n - 1] == '=')
+        pads = s[n - 2] == '=' ? 2 : 1;
+    if(!text_reserve(o, n / 4 * 3 - pads))
+        return o->error;
+
+    /*checked whole before writing, so a bad character leaves the buffer as it was*/
+    if(!text_checkb64(s, n - pads))
+        return TEXT_BADCHAR;
+    if(o->buffer != NULL)
+        text_fromb64(s, n, pads, &o->buffer[o->curbyte]);
+
+    o->curbyte += n / 4 * 3 - pads;
+    return CODEC_OK;
+}
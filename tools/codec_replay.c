@@ -0,0 +1,283 @@
+/*
+ * Replays a capture of raw messages through decode and re-encode with the
+ * stream API on N threads, reporting messages per second, per-message
+ * latency percentiles and the rate of bit-exact round trips.
+ *
+ *   codec_replay [-t threads] [-p passes] [-l] [-T trace] corpus
+ *   codec_replay [-t threads] [-p passes] [-l] [-T trace] -g count [-w corpus]
+ *
+ * A corpus is a frame file: records of a 2-byte big-endian length then
+ * that many message bytes, mapped and indexed by framefile so that each
+ * thread decodes its own contiguous part in place. The first message byte
+ * selects where the field schema starts, the rest is read as a run of bit
+ * fields of cycling widths and written back the same way. -g generates
+ * count synthetic messages in memory instead of reading a corpus, -w also
+ * saves them, -l reads and writes fields LSB-first. Built with CODEC_STATS
+ * it also prints the stream counters, with one latency histogram per
+ * message type. Built with CODEC_TRACE, -T saves the first
+ * CODEC_TRACE_EVENTS accessor calls of every thread as a binary trace for
+ * tools/codec_tracedump; a full ring drops the rest and the trace reports
+ * how many.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "codec.h"
+#include "framefile.h"
+#include "codec_stats.h"
+#include "codec_trace.h"
+
+#define MAX_THREADS    FRAMEFILE_MAXTHREADS
+#define MAX_FIELDS     (8 * MAX_CODEC_BUFFER_LEN)
+#define LATENCY_SLOTS  65536   /*1ns slots, the last one collects everything slower*/
+
+/*field widths in bits, the message type picks the starting entry*/
+static const unsigned char schema[16] = {3, 5, 1, 8, 13, 16, 2, 7, 32, 11, 4, 24, 6, 9, 1, 12};
+
+typedef struct tagT_Worker {
+    unsigned short order;
+    unsigned long messages, exact;
+    unsigned long latency[LATENCY_SLOTS];
+    unsigned int fields[MAX_FIELDS];
+    unsigned char out[MAX_CODEC_BUFFER_LEN];
+} T_Worker;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static unsigned long long nanos(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+/*decode every field of one message and encode it again, 1 if identical*/
+static int roundtrip(const unsigned char *msg, unsigned short len, unsigned short order,
+                     unsigned int *fields, unsigned char *out)
+{
+    T_InputByteStream ibytes;
+    T_InputBitStream ibits;
+    T_OutputByteStream obytes;
+    T_OutputBitStream obits;
+    unsigned int nfields = 0, i, left;
+    unsigned char type, w, k;
+
+    ibytes_init(&ibytes, (unsigned char *)msg, len);
+    type = ibytes_getbyte(&ibytes);
+    ibytes_getbitstream(&ibytes, len - 1, &ibits);
+    ibits_setorder(&ibits, order);
+
+    for(k = type & 15, left = 8u * (len - 1); left > 0; k = (k + 1) & 15)
+    {
+        w = schema[k] < left ? schema[k] : (unsigned char)left;
+        fields[nfields++] = ibits_getbit(&ibits, w);
+        left -= w;
+    }
+
+    obytes_init(&obytes, out, len);
+    obytes_setbyte(&obytes, type);
+    obits_init(&obits, out + 1, len - 1);
+    obits_setorder(&obits, order);
+
+    for(i = 0, k = type & 15, left = 8u * (len - 1); i < nfields; i++, k = (k + 1) & 15)
+    {
+        w = schema[k] < left ? schema[k] : (unsigned char)left;
+        obits_setbit(&obits, w, fields[i]);
+        left -= w;
+    }
+
+    return ibits_geterror(&ibits) == CODEC_OK && obits_geterror(&obits) == CODEC_OK
+        && obytes_geterror(&obytes) == CODEC_OK && memcmp(msg, out, len) == 0;
+}
+
+/*one message on one framefile worker, messages too short for a type byte never match*/
+static unsigned short replay(void *ctx, unsigned int id, T_InputByteStream *msg)
+{
+    T_Worker *w = (T_Worker *)ctx + id;
+    const unsigned char *p = msg->bytes.buffer;
+    unsigned short len = msg->bytes.totallen;
+    unsigned long long t0, t;
+    int exact = 0;
+
+    t0 = nanos();
+    if(len >= 2)
+    {
+        CODEC_STATS_BEGIN(p[0] & 15);
+        exact = roundtrip(p, len, w->order, w->fields, w->out);
+        CODEC_STATS_END();
+    }
+    t = nanos() - t0;
+    w->latency[t < LATENCY_SLOTS ? t : LATENCY_SLOTS - 1] ++;
+    w->messages ++;
+    w->exact += exact;
+
+    return len >= 2 ? CODEC_OK : CODEC_GETTOOBITS;
+}
+
+/*mostly short messages with a tail of long ones, every type equally likely*/
+static unsigned char *generate(unsigned int count, size_t *size)
+{
+    unsigned char *data, *p;
+    unsigned int i, j;
+    unsigned short len;
+    unsigned long seed = 12345;
+
+    data = malloc((size_t)count * (2 + 512));
+    for(i = 0, p = data; i < count; i++)
+    {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        len = (seed >> 33) % 100 < 90 ? 8 + (seed >> 40) % 57 : 65 + (seed >> 40) % 448;
+        *p++ = (unsigned char)(len >> 8);
+        *p++ = (unsigned char)len;
+        for(j = 0; j < len; j++)
+        {
+            seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+            *p++ = (unsigned char)(seed >> 56);
+        }
+    }
+
+    *size = p - data;
+    return data;
+}
+
+static double percentile(const unsigned long *hist, unsigned long total, double q)
+{
+    unsigned long want = (unsigned long)(q * total), seen = 0;
+    unsigned int i;
+
+    for(i = 0; i < LATENCY_SLOTS; i++)
+    {
+        seen += hist[i];
+        if(seen > want)
+            return i;
+    }
+    return LATENCY_SLOTS - 1;
+}
+
+int main(int argc, char **argv)
+{
+    static T_Worker workers[MAX_THREADS];
+    static unsigned long hist[LATENCY_SLOTS];
+    const char *path = NULL, *save = NULL, *trace = NULL;
+    unsigned int nthreads = 1, passes = 1, generated = 0, i, j;
+    unsigned short order = CODEC_MSB_FIRST;
+    unsigned long messages = 0, exact = 0;
+    T_FrameFile corpus;
+    unsigned char *owned = NULL;
+    unsigned short r;
+    size_t size;
+    double t, index;
+
+    for(i = 1; i < (unsigned int)argc; i++)
+    {
+        if(!strcmp(argv[i], "-t") && i + 1 < (unsigned int)argc)
+            nthreads = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "-p") && i + 1 < (unsigned int)argc)
+            passes = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "-g") && i + 1 < (unsigned int)argc)
+            generated = atoi(argv[++i]);
+        else if(!strcmp(argv[i], "-w") && i + 1 < (unsigned int)argc)
+            save = argv[++i];
+        else if(!strcmp(argv[i], "-T") && i + 1 < (unsigned int)argc)
+            trace = argv[++i];
+        else if(!strcmp(argv[i], "-l"))
+            order = CODEC_LSB_FIRST;
+        else if(argv[i][0] != '-' && path == NULL)
+            path = argv[i];
+        else
+            break;
+    }
+
+    if(i < (unsigned int)argc || (path == NULL) == (generated == 0) || nthreads < 1 || nthreads > MAX_THREADS)
+    {
+        fprintf(stderr, "usage: %s [-t threads] [-p passes] [-l] [-T trace] corpus | -g count [-w corpus]\n", argv[0]);
+        return 2;
+    }
+
+    t = now();
+    if(generated)
+    {
+        owned = generate(generated, &size);
+        if(save)
+        {
+            FILE *f = fopen(save, "wb");
+            if(f == NULL || fwrite(owned, 1, size, f) != size)
+            {
+                fprintf(stderr, "cannot write %s\n", save);
+                return 1;
+            }
+            fclose(f);
+        }
+        t = now();
+        r = framefile_attach(&corpus, owned, size);
+    }
+    else
+    {
+        r = framefile_open(&corpus, path);
+    }
+
+    if(r == FRAMEFILE_NOFILE)
+    {
+        fprintf(stderr, "cannot open %s\n", path);
+        return 1;
+    }
+    if(r != CODEC_OK)
+    {
+        fprintf(stderr, "bad record at offset %lu\n", (unsigned long)corpus.bad);
+        return 1;
+    }
+    index = now() - t;
+
+    for(i = 0; i < nthreads; i++)
+        workers[i].order = order;
+
+    t = now();
+    for(i = 0; i < passes; i++)
+        framefile_run(&corpus, nthreads, replay, workers);
+    t = now() - t;
+
+    for(i = 0; i < nthreads; i++)
+    {
+        messages += workers[i].messages;
+        exact += workers[i].exact;
+        for(j = 0; j < LATENCY_SLOTS; j++)
+            hist[j] += workers[i].latency[j];
+    }
+
+    printf("messages   %lu (%u in corpus, %u passes, %u threads)\n", messages, corpus.count, passes, nthreads);
+    printf("rate       %.0f msgs/s, %.1f MB/s, index %.1f ms\n", messages / t, corpus.size * (double)passes / t / 1e6, index * 1e3);
+    printf("latency    p50 %.0f ns, p99 %.0f ns, p999 %.0f ns\n",
+           percentile(hist, messages, 0.50), percentile(hist, messages, 0.99), percentile(hist, messages, 0.999));
+    printf("exact      %lu/%lu (%.4f%%)\n", exact, messages, messages ? 100.0 * exact / messages : 0);
+
+#ifdef CODEC_STATS
+    {
+        static T_CodecStats stats;
+        codec_stats_snapshot(&stats);
+        codec_stats_print(&stats, stdout);
+    }
+#endif
+
+#ifdef CODEC_TRACE
+    if(trace != NULL)
+    {
+        FILE *f = fopen(trace, "wb");
+        if(f == NULL || codec_trace_dump(f) < 0 || fclose(f) != 0)
+            perror(trace);
+    }
+#else
+    if(trace != NULL)
+        fprintf(stderr, "-T needs a build with CODEC_TRACE\n");
+#endif
+
+    framefile_close(&corpus);
+    free(owned);
+
+    return exact != messages;
+}
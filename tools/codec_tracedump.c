@@ -0,0 +1,145 @@
+/*
+ * Renders a binary trace written by codec_trace_dump, one line per event.
+ *
+ *   codec_tracedump [-json] [-op name] [-thread n] trace
+ *
+ * The default output is aligned text; -json writes one object per line.
+ * -op keeps only one accessor (e.g. ibits_getbit), -thread only one
+ * thread. Events dropped on a full ring are reported per block, so a gap
+ * in the sequence is visible rather than silent. A file holding several
+ * dumps one after another is read as one trace.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "codec.h"
+#include "codec_trace.h"
+
+/*a header is 16 bytes like a block, and every dump appended to the file starts with one*/
+static int checkheader(const unsigned char *h)
+{
+    unsigned int words[2];
+
+    if(memcmp(h, CODEC_TRACE_MAGIC, 8) != 0)
+    {
+        fprintf(stderr, "not a codec trace\n");
+        return -1;
+    }
+    memcpy(words, h + 8, sizeof(words));
+    if(words[0] != CODEC_TRACE_VERSION || words[1] != sizeof(T_TraceEvent))
+    {
+        fprintf(stderr, "unsupported trace version or event size\n");
+        return -1;
+    }
+
+    return 0;
+}
+
+static void printevent(const T_TraceBlock *block, const T_TraceEvent *e, int json)
+{
+    const char *name = codec_opname(e->op);
+
+    if(json)
+        printf("{\"thread\":%u,\"stream\":\"0x%llx\",\"op\":\"%s\",\"pos\":%u,\"width\":%u,\"value\":%u}\n",
+               block->thread, e->stream, name, e->pos, e->width, e->value);
+    else
+        printf("%4u  %14llx  %-20s  pos %5u  width %2u  value 0x%08x\n",
+               block->thread, e->stream, name, e->pos, e->width, e->value);
+}
+
+int main(int argc, char **argv)
+{
+    T_TraceBlock block;
+    T_TraceEvent e;
+    FILE *f;
+    const char *path = NULL, *only = NULL;
+    unsigned long long events = 0, shown = 0, dropped = 0;
+    unsigned long long *lastdropped = NULL;
+    unsigned int i, nthreads = 0;
+    int json = 0, thread = -1;
+
+    for(i = 1; i < (unsigned int)argc; i++)
+    {
+        if(!strcmp(argv[i], "-json"))
+            json = 1;
+        else if(!strcmp(argv[i], "-op") && i + 1 < (unsigned int)argc)
+            only = argv[++i];
+        else if(!strcmp(argv[i], "-thread") && i + 1 < (unsigned int)argc)
+            thread = atoi(argv[++i]);
+        else if(argv[i][0] != '-' && path == NULL)
+            path = argv[i];
+        else
+            break;
+    }
+
+    if(i < (unsigned int)argc || path == NULL)
+    {
+        fprintf(stderr, "usage: %s [-json] [-op name] [-thread n] trace\n", argv[0]);
+        return 2;
+    }
+
+    if((f = fopen(path, "rb")) == NULL)
+    {
+        perror(path);
+        return 1;
+    }
+    if(fread(&block, sizeof(block), 1, f) != 1 || checkheader((const unsigned char *)&block) < 0)
+        return 1;
+
+    while(fread(&block, sizeof(block), 1, f) == 1)
+    {
+        if(memcmp(&block, CODEC_TRACE_MAGIC, 8) == 0)
+        {
+            if(checkheader((const unsigned char *)&block) < 0)
+                return 1;
+            continue;
+        }
+
+        if(block.thread >= nthreads)
+        {
+            lastdropped = realloc(lastdropped, (block.thread + 1) * sizeof(*lastdropped));
+            if(lastdropped == NULL)
+                abort();
+            memset(&lastdropped[nthreads], 0, (block.thread + 1 - nthreads) * sizeof(*lastdropped));
+            nthreads = block.thread + 1;
+        }
+
+        for(i = 0; i < block.count; i++)
+        {
+            if(fread(&e, sizeof(e), 1, f) != 1)
+            {
+                fprintf(stderr, "%s: truncated block\n", path);
+                return 1;
+            }
+            events++;
+            if(thread >= 0 && (unsigned int)thread != block.thread)
+                continue;
+            if(only != NULL && strcmp(only, codec_opname(e.op)) != 0)
+                continue;
+            printevent(&block, &e, json);
+            shown++;
+        }
+
+        /*
+         * dropped is cumulative per thread, and a ring only drops when full
+         * so the loss follows these events. It only goes down when the
+         * file holds dumps from more than one run.
+         */
+        if(block.dropped < lastdropped[block.thread])
+            lastdropped[block.thread] = 0;
+        if(block.dropped > lastdropped[block.thread] && (thread < 0 || (unsigned int)thread == block.thread))
+        {
+            if(json)
+                printf("{\"thread\":%u,\"dropped\":%llu}\n", block.thread, block.dropped - lastdropped[block.thread]);
+            else
+                printf("%4u  -- %llu events dropped --\n", block.thread, block.dropped - lastdropped[block.thread]);
+        }
+        dropped += block.dropped - lastdropped[block.thread];
+        lastdropped[block.thread] = block.dropped;
+    }
+
+    fprintf(stderr, "%llu events, %llu shown, %llu dropped\n", events, shown, dropped);
+    free(lastdropped);
+    fclose(f);
+    return 0;
+}